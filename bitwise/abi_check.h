@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+#ifndef ABI_CHECK_H
+#define ABI_CHECK_H
+
+/*
+ * Calling-convention violations reported by abi_call() through its
+ * errors argument. Must match abi_check.s
+ */
+#define ABI_RBX (1u << 0)              // %rbx not preserved
+#define ABI_RBP (1u << 1)              // %rbp not preserved
+#define ABI_R12 (1u << 2)              // %r12 not preserved
+#define ABI_R13 (1u << 3)              // %r13 not preserved
+#define ABI_R14 (1u << 4)              // %r14 not preserved
+#define ABI_R15 (1u << 5)              // %r15 not preserved
+#define ABI_CALLER_FRAME (1u << 6)     // Wrote above its return address
+#define ABI_PAST_RED_ZONE (1u << 7)    // Wrote below its 128-byte red zone
+#define ABI_DIRECTION (1u << 8)        // Returned with the direction flag set
+#define ABI_MXCSR (1u << 9)            // Changed the MXCSR control bits
+#define ABI_X87_CONTROL (1u << 10)     // Changed the x87 control word
+#define NUM_ABI_VIOLATIONS 11
+
+/* Number of values abi_call() loads into %rbx, %rbp and %r12-%r15 */
+#define NUM_ABI_SENTINELS 6
+
+/*
+ * abi_call - Call func(arg1, arg2, arg3) with the callee-saved registers
+ * holding the given sentinels, and check that it followed the calling
+ * convention. Returns func's result, all 64 bits of %rax, and stores
+ * the ABI_* violations in *errors. ABI_PAST_RED_ZONE assumes no signal
+ * handler runs on the calling thread's stack during the call
+ */
+unsigned long abi_call(unsigned long arg1, unsigned long arg2, unsigned long arg3,
+                       int (*func)(void), const unsigned long sentinels[NUM_ABI_SENTINELS],
+                       unsigned *errors);
+
+#endif    // ABI_CHECK_H
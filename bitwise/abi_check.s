@@ -0,0 +1,192 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Calling-convention checking trampoline for btest --abi-check.
+#
+#   unsigned long abi_call(unsigned long arg1, unsigned long arg2,
+#                          unsigned long arg3, int (*func)(void),
+#                          const unsigned long sentinels[6], unsigned *errors);
+#
+# Calls func(arg1, arg2, arg3) the way a compiler would, with the stack
+# 16-byte aligned and the direction flag clear, and checks afterwards
+# that func kept the promises the x86-64 System V ABI makes to callers:
+#
+#   - %rbx, %rbp and %r12-%r15 still hold the values they had before the
+#     call. They are loaded with sentinels[0..5] just before the call, so
+#     a callee that uses one without saving it is caught even when the
+#     value it leaves behind happens to look plausible.
+#   - The caller's frame above the return address is untouched. A callee
+#     that mistakes positive offsets from %rsp for scratch space writes
+#     there instead of into its red zone.
+#   - Nothing was written more than 128 bytes below %rsp, past the red
+#     zone, where a signal handler could overwrite it at any time. Only
+#     the words just past the red zone are checked, so a callee that
+#     properly allocates a larger frame will be flagged too; none of the
+#     puzzles need one. The canaries have to sit below func's %rsp, so
+#     there is no way to reserve them: this check assumes no signal handler
+#     runs on this stack during the call. btest installs none, and signals
+#     with their default action don't touch the stack. A caller that does
+#     handle signals must run its handlers on an alternate stack
+#     (sigaltstack and SA_ONSTACK) or ignore ABI_PAST_RED_ZONE.
+#   - The direction flag is clear, and the MXCSR and x87 control words
+#     are unchanged.
+#
+# The result is func's return value, all of %rax, and *errors is set to
+# the ABI_* flags below, one per broken promise. They must match
+# abi_check.h. The caller's own callee-saved registers, direction flag
+# and control words are restored whatever func did, so btest can carry on
+# after a violation.
+
+.set ABI_RBX,           1 << 0
+.set ABI_RBP,           1 << 1
+.set ABI_R12,           1 << 2
+.set ABI_R13,           1 << 3
+.set ABI_R14,           1 << 4
+.set ABI_R15,           1 << 5
+.set ABI_CALLER_FRAME,  1 << 6
+.set ABI_PAST_RED_ZONE, 1 << 7
+.set ABI_DIRECTION,     1 << 8
+.set ABI_MXCSR,         1 << 9
+.set ABI_X87_CONTROL,   1 << 10
+
+# Frame layout, relative to %rsp at the call:
+#   0-31   canary words func must not write (the caller's frame)
+#   32     pointer to the sentinels
+#   40     MXCSR before the call      44  x87 control word before
+#   48     MXCSR after the call       52  x87 control word after
+#   56     pointer to where the flags go
+# FRAME_SIZE plus the six pushes and the return address is a multiple of
+# 16, so %rsp is 16-byte aligned at the call
+.set FRAME_SIZE, 72
+.set CANARY_WORDS, 4
+.set SENTINELS, 32
+.set MXCSR_BEFORE, 40
+.set X87_CW_BEFORE, 44
+.set MXCSR_AFTER, 48
+.set X87_CW_AFTER, 52
+.set ERRORS, 56
+
+# Offset from %rsp at the call of the canary words past func's red zone:
+# the return address, then 128 bytes of red zone, then the canaries
+.set BELOW_RED_ZONE, -8 - 128 - 8 * CANARY_WORDS
+
+# Fill the canary words at offset(%rsp) with %rax
+.macro fill_canaries offset
+    .irp i, 0, 1, 2, 3
+    movq    %rax, \offset + 8 * \i(%rsp)
+    .endr
+.endm
+
+# Set flag in %r9d if any canary word at offset(%rsp) differs from %rax
+.macro check_canaries offset, flag
+    movq    \offset(%rsp), %r10
+    .irp i, 1, 2, 3
+    orq     \offset + 8 * \i(%rsp), %r10
+    .endr
+    movq    \offset(%rsp), %r11
+    .irp i, 1, 2, 3
+    andq    \offset + 8 * \i(%rsp), %r11
+    .endr
+    # All four words equal %rax exactly when their OR and AND both do
+    cmpq    %rax, %r10
+    jne     1f
+    cmpq    %rax, %r11
+    je      2f
+1:
+    orl     $\flag, %r9d
+2:
+.endm
+
+# Set flag in %r9d if reg no longer holds sentinel number index
+.macro check_reg reg, index, flag
+    cmpq    8 * \index(%r8), \reg
+    je      1f
+    orl     $\flag, %r9d
+1:
+.endm
+
+    .text
+    .global abi_call
+abi_call:
+    pushq   %rbx
+    pushq   %rbp
+    pushq   %r12
+    pushq   %r13
+    pushq   %r14
+    pushq   %r15
+    subq    $FRAME_SIZE, %rsp
+    movq    %r8, SENTINELS(%rsp)
+    movq    %r9, ERRORS(%rsp)
+    stmxcsr MXCSR_BEFORE(%rsp)
+    fnstcw  X87_CW_BEFORE(%rsp)
+
+    # The canaries are the complement of the first sentinel, so they
+    # differ from every value func is likely to store
+    movq    (%r8), %rax
+    notq    %rax
+    fill_canaries 0
+    fill_canaries BELOW_RED_ZONE
+
+    movq    %rcx, %r11
+    movq    0(%r8), %rbx
+    movq    8(%r8), %rbp
+    movq    16(%r8), %r12
+    movq    24(%r8), %r13
+    movq    32(%r8), %r14
+    movq    40(%r8), %r15
+    xorl    %eax, %eax                # Don't hand func the canary value
+    cld
+    call    *%r11
+
+    movq    %rax, %rcx                # func's result
+    xorl    %r9d, %r9d
+    movq    SENTINELS(%rsp), %r8
+    check_reg %rbx, 0, ABI_RBX
+    check_reg %rbp, 1, ABI_RBP
+    check_reg %r12, 2, ABI_R12
+    check_reg %r13, 3, ABI_R13
+    check_reg %r14, 4, ABI_R14
+    check_reg %r15, 5, ABI_R15
+
+    movq    (%r8), %rax
+    notq    %rax
+    check_canaries 0, ABI_CALLER_FRAME
+    check_canaries BELOW_RED_ZONE, ABI_PAST_RED_ZONE
+
+    pushfq
+    popq    %r10
+    testl   $0x400, %r10d             # DF
+    jz      1f
+    orl     $ABI_DIRECTION, %r9d
+    cld
+1:
+    # Compare only the control bits of MXCSR, not the exception flags
+    # that any floating-point instruction may set
+    stmxcsr MXCSR_AFTER(%rsp)
+    movl    MXCSR_AFTER(%rsp), %r10d
+    xorl    MXCSR_BEFORE(%rsp), %r10d
+    testl   $0xffc0, %r10d
+    jz      1f
+    orl     $ABI_MXCSR, %r9d
+    ldmxcsr MXCSR_BEFORE(%rsp)
+1:
+    fnstcw  X87_CW_AFTER(%rsp)
+    movzwl  X87_CW_AFTER(%rsp), %r10d
+    cmpw    X87_CW_BEFORE(%rsp), %r10w
+    je      1f
+    orl     $ABI_X87_CONTROL, %r9d
+    fldcw   X87_CW_BEFORE(%rsp)
+1:
+
+    movq    ERRORS(%rsp), %r10
+    movl    %r9d, (%r10)
+    movq    %rcx, %rax
+    addq    $FRAME_SIZE, %rsp
+    popq    %r15
+    popq    %r14
+    popq    %r13
+    popq    %r12
+    popq    %rbp
+    popq    %rbx
+    ret
+
+.section .note.GNU-stack,"",@progbits
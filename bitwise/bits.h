@@ -3,6 +3,8 @@
 #ifndef BITS_H
 #define BITS_H
 
+#include <stddef.h>
+
 int allOddBits(int);
 int anyEvenBit(int);
 int bitAnd(int, int);
@@ -16,4 +18,79 @@ int isPower2(int);
 int replaceByte(int, int, int);
 int rotateLeft(int, int);
 
+// 64-bit versions (bits64.s). Double arguments are passed as their bit
+// pattern
+int allOddBits64(long);
+int anyEvenBit64(long);
+long bitAnd64(long, long);
+long bitMask64(int, int);
+long bitXor64(long, long);
+int doubleIsEqual(unsigned long, unsigned long);
+unsigned long doubleScale2(unsigned long);
+int isLess64(long, long);
+int isPositive64(long);
+int isPower2_64(long);
+long replaceByte64(long, int, int);
+long rotateLeft64(long, int);
+
+// Versions using instruction set extensions (bits_bmi.s). Callers must
+// check that the CPU supports them, see dispatch.h
+int allOddBits_bmi1(int);
+int bitMask_bmi2(int, int);
+int isPower2_bmi1(int);
+int isPower2_popcnt(int);
+int replaceByte_bmi2(int, int, int);
+
+// Call the best of the versions above that the CPU supports, chosen
+// once when the program is loaded (dispatch.c)
+int allOddBits_auto(int);
+int bitMask_auto(int, int);
+int isPower2_auto(int);
+int replaceByte_auto(int, int, int);
+
+// Batched versions (bits_n.s): out[i] = puzzle(x[i], ...) for 0 <= i < n
+// These use AVX2, so callers must check that the CPU supports it. out may
+// be the same array as an input, e.g. to rescale a buffer of floats in
+// place with floatScale2_n
+void allOddBits_n(const int *x, int *out, size_t n);
+void anyEvenBit_n(const int *x, int *out, size_t n);
+void bitAnd_n(const int *x, const int *y, int *out, size_t n);
+void bitMask_n(const int *highbit, const int *lowbit, int *out, size_t n);
+void bitXor_n(const int *x, const int *y, int *out, size_t n);
+void floatIsEqual_n(const unsigned *uf, const unsigned *ug, int *out, size_t n);
+void floatScale2_n(const unsigned *uf, unsigned *out, size_t n);
+void isLess_n(const int *x, const int *y, int *out, size_t n);
+void isPositive_n(const int *x, int *out, size_t n);
+void isPower2_n(const int *x, int *out, size_t n);
+void replaceByte_n(const int *x, const int *n, const int *c, int *out, size_t count);
+void rotateLeft_n(const int *x, const int *n, int *out, size_t count);
+
+// AVX-512 versions of the batched float puzzles (bits_n512.s), which
+// need a CPU with AVX512F
+void floatIsEqual_n_avx512(const unsigned *uf, const unsigned *ug, int *out, size_t n);
+void floatScale2_n_avx512(const unsigned *uf, unsigned *out, size_t n);
+
+// Call the AVX-512 versions if the CPU supports them and the AVX2 ones
+// otherwise, chosen once when the program is loaded (dispatch.c)
+void floatIsEqual_n_auto(const unsigned *uf, const unsigned *ug, int *out, size_t n);
+void floatScale2_n_auto(const unsigned *uf, unsigned *out, size_t n);
+
+// Reductions (bits_reduce.s) of the predicate puzzles over the n words at
+// x: how many words the puzzle is true for, whether it is true for any
+// and whether it is true for all. any_ and all_ return as soon as the
+// answer is known. These use AVX2, so callers must check that the CPU
+// supports it
+size_t count_allOddBits(const int *x, size_t n);
+size_t count_anyEvenBit(const int *x, size_t n);
+size_t count_isPositive(const int *x, size_t n);
+size_t count_isPower2(const int *x, size_t n);
+int any_allOddBits(const int *x, size_t n);
+int any_anyEvenBit(const int *x, size_t n);
+int any_isPositive(const int *x, size_t n);
+int any_isPower2(const int *x, size_t n);
+int all_allOddBits(const int *x, size_t n);
+int all_anyEvenBit(const int *x, size_t n);
+int all_isPositive(const int *x, size_t n);
+int all_isPower2(const int *x, size_t n);
+
 #endif    // BITS_H
@@ -344,3 +344,5 @@ isPower2:
 .ret_zero:
     xorl    %eax, %eax
     ret
+
+.section .note.GNU-stack,"",@progbits
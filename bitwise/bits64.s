@@ -0,0 +1,232 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# 64-bit versions of the puzzles in bits.s. They work the same way on
+# 64-bit longs, and on doubles passed as their 64-bit pattern in an
+# unsigned long, and follow the same rules as the puzzles in bits.s. They
+# are part of the test harness rather than the assignment, so they are
+# tested but not graded.
+
+# bitXor64 - Compute x^y for 64-bit x and y
+#   Example: bitXor64(4, 5) = 1
+#   Rating: 1
+.global bitXor64
+bitXor64:
+    # args: x in %rdi, y in %rsi
+    movq    %rdi, %rax
+    movq    %rsi, %rcx
+    notq    %rcx              # rcx = ~y
+    andq    %rcx, %rax        # rax = x & ~y
+    notq    %rdi
+    andq    %rsi, %rdi        # rdi = ~x & y
+    orq     %rdi, %rax        # rax = (x & ~y) | (~x & y)
+    ret
+
+# bitAnd64 - Compute x&y for 64-bit x and y
+#   Example: bitAnd64(6, 5) = 4
+#   Rating: 1
+.global bitAnd64
+bitAnd64:
+    movq    %rdi, %rax
+    notq    %rax              # rax = ~x
+    notq    %rsi              # rsi = ~y
+    orq     %rsi, %rax        # rax = ~x | ~y
+    notq    %rax              # rax = ~(~x | ~y) = x & y
+    ret
+
+# allOddBits64 - return 1 if all odd-numbered bits in a 64-bit word are
+#   set to 1, where bits are numbered from 0 (least significant) to 63
+#   Examples: allOddBits64(0xFFFFFFFFFFFFFFFD) = 0,
+#             allOddBits64(0xAAAAAAAAAAAAAAAA) = 1
+#   Rating: 2
+.global allOddBits64
+allOddBits64:
+    movabsq $0xAAAAAAAAAAAAAAAA, %rcx
+    andq    %rcx, %rdi        # keep only the odd bits of x
+    xorl    %eax, %eax
+    cmpq    %rcx, %rdi
+    sete    %al               # 1 if every odd bit was set
+    ret
+
+# doubleIsEqual - Compute f == g for double-precision arguments f and g.
+#   Both arguments are passed as unsigned long's, but they are to be
+#   interpreted as the bit-level representations of double-precision
+#   floating point values.
+#   If either argument is NaN, return 0.
+#   +0 and -0 are considered equal.
+#   Rating: 2
+.global doubleIsEqual
+doubleIsEqual:
+    # Shifting out the sign leaves exp and frac at the top, so a NaN
+    # (exp all ones, frac nonzero) is anything above 0xFFE0000000000000
+    movabsq $0xFFE0000000000000, %rcx
+    leaq    (%rdi,%rdi), %rax  # rax = f without its sign
+    cmpq    %rcx, %rax
+    ja      .double_not_equal
+    leaq    (%rsi,%rsi), %rdx  # rdx = g without its sign
+    cmpq    %rcx, %rdx
+    ja      .double_not_equal
+
+    orq     %rdx, %rax         # both +0 or -0?
+    jz      .double_equal
+    xorl    %eax, %eax
+    cmpq    %rsi, %rdi
+    sete    %al                # otherwise equal only if the bits are
+    ret
+
+.double_equal:
+    movl    $1, %eax
+    ret
+
+.double_not_equal:
+    xorl    %eax, %eax
+    ret
+
+# anyEvenBit64 - return 1 if any even-numbered bit in a 64-bit word is
+#   set to 1, where bits are numbered from 0 (least significant) to 63
+#   Examples: anyEvenBit64(0xA) = 0, anyEvenBit64(0xE) = 1
+#   Rating: 2
+.global anyEvenBit64
+anyEvenBit64:
+    movabsq $0x5555555555555555, %rcx
+    xorl    %eax, %eax
+    testq   %rcx, %rdi
+    setne   %al
+    ret
+
+# isPositive64 - return 1 if x > 0, return 0 otherwise
+#   Example: isPositive64(-1) = 0.
+#   Rating: 2
+.global isPositive64
+isPositive64:
+    xorl    %eax, %eax
+    testq   %rdi, %rdi
+    setg    %al
+    ret
+
+# replaceByte64(x,n,c) - Replace byte n in 64-bit x with c
+#   Bytes numbered from 0 (LSB) to 7 (MSB)
+#   Examples: replaceByte64(0x12345678, 1, 0xab) = 0x1234ab78
+#   You can assume 0 <= n <= 7 and 0 <= c <= 255
+#   Rating: 3
+.global replaceByte64
+replaceByte64:
+    # args: x in %rdi, n in %esi, c in %edx
+    movl    %esi, %ecx
+    shll    $3, %ecx           # cl = n * 8
+    movl    $0xFF, %eax
+    shlq    %cl, %rax          # rax = 0xFF << (n * 8)
+    notq    %rax
+    andq    %rdi, %rax         # clear byte n of x
+    movzbl  %dl, %edx
+    shlq    %cl, %rdx          # rdx = c << (n * 8)
+    orq     %rdx, %rax
+    ret
+
+# isLess64 - if x < y then return 1, else return 0
+#   Example: isLess64(4, 5) = 1.
+#   Rating: 3
+.global isLess64
+isLess64:
+    xorl    %eax, %eax
+    cmpq    %rsi, %rdi
+    setl    %al
+    ret
+
+# rotateLeft64 - Rotate 64-bit x to the left by n
+#   Can assume that 0 <= n <= 63
+#   Examples: rotateLeft64(0x8765432100000000, 4) = 0x7654321000000008
+#   Rating: 3
+.global rotateLeft64
+rotateLeft64:
+    movq    %rdi, %rax
+    movl    %esi, %ecx
+    rolq    %cl, %rax
+    ret
+
+# bitMask64 - Generate a 64-bit mask consisting of all 1's between
+#   lowbit and highbit
+#   Examples: bitMask64(5, 3) = 0x38
+#   Assume 0 <= lowbit <= 63, and 0 <= highbit <= 63
+#   If lowbit > highbit, then mask should be all 0's
+#   Rating: 3
+.global bitMask64
+bitMask64:
+    # (~0 >> (63 - highbit)) & (~0 << lowbit), which is empty when
+    # lowbit > highbit
+    movl    $63, %ecx
+    subl    %edi, %ecx
+    movq    $-1, %rax
+    shrq    %cl, %rax          # rax = bits at or below highbit
+    movl    %esi, %ecx
+    movq    $-1, %rdx
+    shlq    %cl, %rdx          # rdx = bits at or above lowbit
+    andq    %rdx, %rax
+    ret
+
+# doubleScale2 - Return bit-level equivalent of expression 2*f for
+#   floating point argument f.
+#   Both the argument and result are passed as unsigned long's, but
+#   they are to be interpreted as the bit-level representation of
+#   double-precision floating point values.
+#   When argument is NaN, return argument
+#   Rating: 4
+.global doubleScale2
+doubleScale2:
+    movq    %rdi, %rax
+    movq    %rdi, %rdx
+    shrq    $52, %rdx
+    andl    $0x7FF, %edx           # edx = exp
+
+    # if (exp == 0x7FF) return uf
+    cmpl    $0x7FF, %edx
+    je      .double_ret_uf
+
+    # if (exp == 0)
+    testl   %edx, %edx
+    jne     .double_normalized
+
+    # denormalized: return sign | (frac << 1). A frac that overflows into
+    # the exponent becomes the smallest normalized value, which is right
+    movabsq $0x8000000000000000, %rcx
+    andq    %rcx, %rax             # rax = sign
+    addq    %rdi, %rdi             # frac << 1, shifting the sign out
+    orq     %rdi, %rax
+    ret
+
+.double_normalized:
+    cmpl    $0x7FE, %edx
+    je      .double_make_inf       # if exp + 1 == 0x7FF → inf
+
+    # exp += 1
+    movabsq $0x0010000000000000, %rcx
+    addq    %rcx, %rax
+    ret
+
+.double_make_inf:
+    # sign | (0x7FF << 52)
+    movabsq $0x8000000000000000, %rcx
+    andq    %rcx, %rax
+    movabsq $0x7FF0000000000000, %rcx
+    orq     %rcx, %rax
+    ret
+
+.double_ret_uf:
+    ret                            # rax = uf
+
+# isPower2_64 - returns 1 if 64-bit x is a power of 2, and 0 otherwise
+#   Examples: isPower2_64(5) = 0, isPower2_64(8) = 1, isPower2_64(0) = 0
+#   Note that no negative number is a power of 2.
+#   Rating: 4
+.global isPower2_64
+isPower2_64:
+    # return (x > 0) && ((x & (x-1)) == 0)
+    xorl    %eax, %eax
+    testq   %rdi, %rdi
+    jle     .not_power2_64
+    leaq    -1(%rdi), %rcx     # rcx = x-1
+    testq   %rcx, %rdi
+    sete    %al
+.not_power2_64:
+    ret
+
+.section .note.GNU-stack,"",@progbits
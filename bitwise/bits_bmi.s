@@ -0,0 +1,77 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Versions of some puzzles in bits.s that use the BMI1, BMI2 or POPCNT
+# instruction set extensions, named after the puzzle and the extension:
+#
+#   allOddBits_bmi1     andn clears the odd bits x has, leaving ZF set
+#                       exactly when none are missing
+#   bitMask_bmi2        bzhi builds both halves of the mask straight from
+#                       highbit and lowbit, and andn combines them
+#   isPower2_bmi1       blsr clears the lowest set bit
+#   isPower2_popcnt     popcnt counts the set bits
+#   replaceByte_bmi2    shlx shifts by n * 8 without going through %cl,
+#                       and andn clears the byte
+#
+# dispatch.c lists them and picks the best one the CPU supports for the
+# NAME_auto entry points. Callers must make sure the CPU supports an
+# extension before calling a version that uses it.
+#
+# bitMask_bmi2 and replaceByte_bmi2 also use andn, so they need BMI1 as
+# well, which every CPU with BMI2 has.
+
+# allOddBits_bmi1 - allOddBits using andn
+.global allOddBits_bmi1
+allOddBits_bmi1:
+    movl    $0xAAAAAAAA, %ecx
+    xorl    %eax, %eax
+    andnl   %ecx, %edi, %edx          # edx = odd bits missing from x
+    sete    %al
+    ret
+
+# bitMask_bmi2 - bitMask using bzhi and andn
+.global bitMask_bmi2
+bitMask_bmi2:
+    # args: highbit in %edi, lowbit in %esi
+    movl    $-1, %edx
+    leal    1(%rdi), %ecx
+    bzhil   %ecx, %edx, %eax          # eax = bits at or below highbit
+    bzhil   %esi, %edx, %edx          # edx = bits below lowbit
+    andnl   %eax, %edx, %eax          # eax = ~edx & eax, empty if lowbit > highbit
+    ret
+
+# isPower2_bmi1 - isPower2 using blsr
+.global isPower2_bmi1
+isPower2_bmi1:
+    xorl    %eax, %eax
+    xorl    %edx, %edx
+    blsrl   %edi, %ecx                # ZF set if x has at most one bit set
+    sete    %al
+    testl   %edi, %edi
+    cmovle  %edx, %eax                # but 0 and negative x are not powers of 2
+    ret
+
+# isPower2_popcnt - isPower2 using popcnt
+.global isPower2_popcnt
+isPower2_popcnt:
+    xorl    %eax, %eax
+    xorl    %edx, %edx
+    popcntl %edi, %ecx
+    cmpl    $1, %ecx
+    sete    %al                       # exactly one bit set
+    testl   %edi, %edi
+    cmovle  %edx, %eax                # but not just the sign bit
+    ret
+
+# replaceByte_bmi2 - replaceByte using shlx and andn
+.global replaceByte_bmi2
+replaceByte_bmi2:
+    # args: x in %edi, n in %esi, c in %edx
+    shll    $3, %esi                  # shift = n * 8
+    movl    $0xFF, %eax
+    shlxl   %esi, %eax, %eax          # mask = 0xFF << shift
+    andnl   %edi, %eax, %eax          # eax = x & ~mask
+    shlxl   %esi, %edx, %edx          # edx = c << shift
+    orl     %edx, %eax
+    ret
+
+.section .note.GNU-stack,"",@progbits
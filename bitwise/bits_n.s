@@ -0,0 +1,251 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Batched versions of the puzzles in bits.s. Each NAME_n function computes
+# out[i] = NAME(x[i], ...) for 0 <= i < n, so bulk callers pay for one
+# call instead of one per element.
+#
+# The main loop handles 8 elements per iteration with AVX2. The remaining
+# n % 8 elements are handled one at a time by a tail loop that runs the
+# same instructions on the low lane of the xmm registers. Callers must
+# make sure the CPU supports AVX2 before calling any of these functions.
+#
+# Only caller-saved registers are used, so nothing needs to be pushed.
+
+# Each kernel body below is a macro taking the register class to work
+# on: "y" for the 8-wide loop and "x" for the tail. The first input is
+# in register 0, further inputs in registers 1 and 2, and the result is
+# left in register 0. Registers 3-7 are scratch. Constants are placed in
+# registers 8 and up by the kernel's setup macro before the loops start.
+# The predicates allOddBits, anyEvenBit, isPositive and isPower2 come from
+# bits_macros.inc, which bits_reduce.s shares.
+
+.include "bits_macros.inc"
+
+# One input array: x in %rdi, out in %rsi, n in %rdx
+.macro batch1 name, body, setup=no_consts
+.global \name
+\name:
+    \setup
+    xorl    %eax, %eax                # i = 0
+    movq    %rdx, %r9
+    andq    $-8, %r9                  # r9 = n rounded down to a multiple of 8
+    jmp     .\name\()_vec_check
+.\name\()_vec:
+    vmovdqu (%rdi,%rax,4), %ymm0
+    \body   y
+    vmovdqu %ymm0, (%rsi,%rax,4)
+    addq    $8, %rax
+.\name\()_vec_check:
+    cmpq    %r9, %rax
+    jb      .\name\()_vec
+    jmp     .\name\()_tail_check
+.\name\()_tail:
+    vmovd   (%rdi,%rax,4), %xmm0
+    \body   x
+    vmovd   %xmm0, (%rsi,%rax,4)
+    incq    %rax
+.\name\()_tail_check:
+    cmpq    %rdx, %rax
+    jb      .\name\()_tail
+    vzeroupper
+    ret
+.endm
+
+# Two input arrays: x in %rdi, y in %rsi, out in %rdx, n in %rcx
+.macro batch2 name, body, setup=no_consts
+.global \name
+\name:
+    \setup
+    xorl    %eax, %eax
+    movq    %rcx, %r9
+    andq    $-8, %r9
+    jmp     .\name\()_vec_check
+.\name\()_vec:
+    vmovdqu (%rdi,%rax,4), %ymm0
+    vmovdqu (%rsi,%rax,4), %ymm1
+    \body   y
+    vmovdqu %ymm0, (%rdx,%rax,4)
+    addq    $8, %rax
+.\name\()_vec_check:
+    cmpq    %r9, %rax
+    jb      .\name\()_vec
+    jmp     .\name\()_tail_check
+.\name\()_tail:
+    vmovd   (%rdi,%rax,4), %xmm0
+    vmovd   (%rsi,%rax,4), %xmm1
+    \body   x
+    vmovd   %xmm0, (%rdx,%rax,4)
+    incq    %rax
+.\name\()_tail_check:
+    cmpq    %rcx, %rax
+    jb      .\name\()_tail
+    vzeroupper
+    ret
+.endm
+
+# Three input arrays: x in %rdi, y in %rsi, z in %rdx, out in %rcx, n in %r8
+.macro batch3 name, body, setup=no_consts
+.global \name
+\name:
+    \setup
+    xorl    %eax, %eax
+    movq    %r8, %r9
+    andq    $-8, %r9
+    jmp     .\name\()_vec_check
+.\name\()_vec:
+    vmovdqu (%rdi,%rax,4), %ymm0
+    vmovdqu (%rsi,%rax,4), %ymm1
+    vmovdqu (%rdx,%rax,4), %ymm2
+    \body   y
+    vmovdqu %ymm0, (%rcx,%rax,4)
+    addq    $8, %rax
+.\name\()_vec_check:
+    cmpq    %r9, %rax
+    jb      .\name\()_vec
+    jmp     .\name\()_tail_check
+.\name\()_tail:
+    vmovd   (%rdi,%rax,4), %xmm0
+    vmovd   (%rsi,%rax,4), %xmm1
+    vmovd   (%rdx,%rax,4), %xmm2
+    \body   x
+    vmovd   %xmm0, (%rcx,%rax,4)
+    incq    %rax
+.\name\()_tail_check:
+    cmpq    %r8, %rax
+    jb      .\name\()_tail
+    vzeroupper
+    ret
+.endm
+
+# bitXor_n(const int *x, const int *y, int *out, size_t n)
+.macro bitXor_body r
+    vpxor   %\r\()mm1, %\r\()mm0, %\r\()mm0
+.endm
+batch2 bitXor_n, bitXor_body
+
+# bitAnd_n(const int *x, const int *y, int *out, size_t n)
+.macro bitAnd_body r
+    vpand   %\r\()mm1, %\r\()mm0, %\r\()mm0
+.endm
+batch2 bitAnd_n, bitAnd_body
+
+# allOddBits_n(const int *x, int *out, size_t n)
+.macro allOddBits_body r
+    allOddBits_pred \r
+    vpsrld  $31, %\r\()mm0, %\r\()mm0          # -1 -> 1
+.endm
+batch1 allOddBits_n, allOddBits_body, allOddBits_pred_consts
+
+# floatIsEqual_n(const unsigned *uf, const unsigned *ug, int *out, size_t n)
+.macro floatIsEqual_consts
+    broadcast 0x7FFFFFFF, 8
+    broadcast 0x7F800000, 9
+    vpxor   %ymm10, %ymm10, %ymm10
+.endm
+.macro floatIsEqual_body r
+    vpand   %\r\()mm8, %\r\()mm0, %\r\()mm2     # |f|
+    vpand   %\r\()mm8, %\r\()mm1, %\r\()mm3     # |g|
+    vpcmpeqd %\r\()mm1, %\r\()mm0, %\r\()mm0    # uf == ug
+    vpor    %\r\()mm3, %\r\()mm2, %\r\()mm4
+    vpcmpeqd %\r\()mm10, %\r\()mm4, %\r\()mm4   # both are +0 or -0
+    vpor    %\r\()mm4, %\r\()mm0, %\r\()mm0
+    vpcmpgtd %\r\()mm9, %\r\()mm2, %\r\()mm2    # |f| > inf means f is NaN
+    vpcmpgtd %\r\()mm9, %\r\()mm3, %\r\()mm3    # |g| > inf means g is NaN
+    vpor    %\r\()mm3, %\r\()mm2, %\r\()mm2
+    vpandn  %\r\()mm0, %\r\()mm2, %\r\()mm0     # never equal if either is NaN
+    vpsrld  $31, %\r\()mm0, %\r\()mm0
+.endm
+batch2 floatIsEqual_n, floatIsEqual_body, floatIsEqual_consts
+
+# anyEvenBit_n(const int *x, int *out, size_t n)
+.macro anyEvenBit_body r
+    anyEvenBit_pred \r
+    vpsrld  $31, %\r\()mm0, %\r\()mm0
+.endm
+batch1 anyEvenBit_n, anyEvenBit_body, anyEvenBit_pred_consts
+
+# isPositive_n(const int *x, int *out, size_t n)
+.macro isPositive_body r
+    isPositive_pred \r
+    vpsrld  $31, %\r\()mm0, %\r\()mm0
+.endm
+batch1 isPositive_n, isPositive_body, isPositive_pred_consts
+
+# replaceByte_n(const int *x, const int *n, const int *c, int *out, size_t count)
+.macro replaceByte_consts
+    broadcast 0xFF, 8
+.endm
+.macro replaceByte_body r
+    vpslld  $3, %\r\()mm1, %\r\()mm1            # shift = n << 3
+    vpsllvd %\r\()mm1, %\r\()mm8, %\r\()mm3     # mask = 0xFF << shift
+    vpsllvd %\r\()mm1, %\r\()mm2, %\r\()mm2     # c << shift
+    vpandn  %\r\()mm0, %\r\()mm3, %\r\()mm0     # x & ~mask
+    vpor    %\r\()mm2, %\r\()mm0, %\r\()mm0
+.endm
+batch3 replaceByte_n, replaceByte_body, replaceByte_consts
+
+# isLess_n(const int *x, const int *y, int *out, size_t n)
+.macro isLess_body r
+    vpcmpgtd %\r\()mm0, %\r\()mm1, %\r\()mm0    # -1 if y > x
+    vpsrld  $31, %\r\()mm0, %\r\()mm0
+.endm
+batch2 isLess_n, isLess_body
+
+# rotateLeft_n(const int *x, const int *n, int *out, size_t count)
+.macro rotateLeft_consts
+    broadcast 32, 8
+.endm
+.macro rotateLeft_body r
+    vpsubd  %\r\()mm1, %\r\()mm8, %\r\()mm2     # 32 - n
+    vpsrlvd %\r\()mm2, %\r\()mm0, %\r\()mm2     # x >> (32 - n), which is 0 when n = 0
+    vpsllvd %\r\()mm1, %\r\()mm0, %\r\()mm0     # x << n
+    vpor    %\r\()mm2, %\r\()mm0, %\r\()mm0
+.endm
+batch2 rotateLeft_n, rotateLeft_body, rotateLeft_consts
+
+# bitMask_n(const int *highbit, const int *lowbit, int *out, size_t n)
+.macro bitMask_consts
+    vpcmpeqd %ymm8, %ymm8, %ymm8               # all ones
+    broadcast 31, 9
+.endm
+.macro bitMask_body r
+    vpsubd  %\r\()mm0, %\r\()mm9, %\r\()mm2     # 31 - highbit
+    vpsrlvd %\r\()mm2, %\r\()mm8, %\r\()mm2     # ones in bits 0..highbit
+    vpsllvd %\r\()mm1, %\r\()mm8, %\r\()mm0     # ones in bits lowbit..31
+    vpand   %\r\()mm2, %\r\()mm0, %\r\()mm0     # empty when lowbit > highbit
+.endm
+batch2 bitMask_n, bitMask_body, bitMask_consts
+
+# floatScale2_n(const unsigned *uf, unsigned *out, size_t n)
+.macro floatScale2_consts
+    broadcast 0x7FFFFFFF, 8
+    broadcast 0x00800000, 9
+    broadcast 0x7F800000, 10
+    vpxor   %ymm11, %ymm11, %ymm11
+    broadcast 0x7F000000, 12
+.endm
+.macro floatScale2_body r
+    vpand   %\r\()mm8, %\r\()mm0, %\r\()mm1     # |f|
+    vpxor   %\r\()mm1, %\r\()mm0, %\r\()mm2     # sign
+    vpand   %\r\()mm10, %\r\()mm1, %\r\()mm3    # exponent field
+    vpaddd  %\r\()mm9, %\r\()mm0, %\r\()mm4     # normalized: exp += 1
+    vpor    %\r\()mm10, %\r\()mm2, %\r\()mm5    # sign | inf
+    vpcmpeqd %\r\()mm12, %\r\()mm3, %\r\()mm6   # exp == 0xFE overflows to inf
+    vpblendvb %\r\()mm6, %\r\()mm5, %\r\()mm4, %\r\()mm4
+    vpslld  $1, %\r\()mm1, %\r\()mm5
+    vpor    %\r\()mm2, %\r\()mm5, %\r\()mm5     # denormalized: sign | frac << 1
+    vpcmpeqd %\r\()mm11, %\r\()mm3, %\r\()mm6   # exp == 0
+    vpblendvb %\r\()mm6, %\r\()mm5, %\r\()mm4, %\r\()mm4
+    vpcmpeqd %\r\()mm10, %\r\()mm3, %\r\()mm6   # exp == 0xFF: inf or NaN, unchanged
+    vpblendvb %\r\()mm6, %\r\()mm0, %\r\()mm4, %\r\()mm0
+.endm
+batch1 floatScale2_n, floatScale2_body, floatScale2_consts
+
+# isPower2_n(const int *x, int *out, size_t n)
+.macro isPower2_body r
+    isPower2_pred \r
+    vpsrld  $31, %\r\()mm0, %\r\()mm0
+.endm
+batch1 isPower2_n, isPower2_body, isPower2_pred_consts
+
+.section .note.GNU-stack,"",@progbits
@@ -0,0 +1,138 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# AVX-512 versions of the batched float puzzles in bits_n.s, with the same
+# arguments and results. The main loop handles 16 elements per iteration.
+# Instead of a scalar tail loop, the last n % 16 elements are handled by
+# one more iteration whose loads and stores are masked to the elements
+# that exist, so nothing past the end of the arrays is touched. Callers
+# must make sure the CPU supports AVX512F before calling these.
+#
+# out may be the same array as an input, so a buffer can be rescaled in
+# place: every element is loaded before its result is stored.
+#
+# The kernels work on mask registers where bits_n.s blends with vectors:
+# each special case is a compare into a mask and a masked move. %k7 holds
+# the tail mask, %k1-%k4 are scratch, as are %zmm1-%zmm7. Constants are
+# placed in %zmm8 and up by the kernel's setup macro.
+
+# Broadcast a 32-bit constant into every lane of %zmm<reg>
+.macro broadcast512 value, reg
+    movl    $\value, %eax
+    vpbroadcastd %eax, %zmm\reg
+.endm
+
+# Set %k7 to the low \count bits, for count in 1..15. Clobbers %ecx
+.macro tail_mask count
+    movl    \count, %ecx
+    movl    $1, %r8d
+    shll    %cl, %r8d
+    decl    %r8d
+    kmovw   %r8d, %k7
+.endm
+
+# One input array: x in %rdi, out in %rsi, n in %rdx. body leaves its
+# result in %zmm0
+.macro batch1_512 name, body, setup
+.global \name
+\name:
+    \setup
+    xorl    %eax, %eax                # i = 0
+    movq    %rdx, %r9
+    andq    $-16, %r9                 # r9 = n rounded down to a multiple of 16
+    jmp     .\name\()_vec_check
+.\name\()_vec:
+    vmovdqu32 (%rdi,%rax,4), %zmm0
+    \body
+    vmovdqu32 %zmm0, (%rsi,%rax,4)
+    addq    $16, %rax
+.\name\()_vec_check:
+    cmpq    %r9, %rax
+    jb      .\name\()_vec
+    movq    %rdx, %r10
+    subq    %rax, %r10                # elements left, 0-15
+    jz      .\name\()_done
+    tail_mask %r10d
+    vmovdqu32 (%rdi,%rax,4), %zmm0{%k7}{z}
+    \body
+    vmovdqu32 %zmm0, (%rsi,%rax,4){%k7}
+.\name\()_done:
+    vzeroupper
+    ret
+.endm
+
+# Two input arrays: x in %rdi, y in %rsi, out in %rdx, n in %rcx
+.macro batch2_512 name, body, setup
+.global \name
+\name:
+    \setup
+    xorl    %eax, %eax
+    movq    %rcx, %r9
+    andq    $-16, %r9
+    jmp     .\name\()_vec_check
+.\name\()_vec:
+    vmovdqu32 (%rdi,%rax,4), %zmm0
+    vmovdqu32 (%rsi,%rax,4), %zmm1
+    \body
+    vmovdqu32 %zmm0, (%rdx,%rax,4)
+    addq    $16, %rax
+.\name\()_vec_check:
+    cmpq    %r9, %rax
+    jb      .\name\()_vec
+    movq    %rcx, %r10
+    subq    %rax, %r10
+    jz      .\name\()_done
+    tail_mask %r10d
+    vmovdqu32 (%rdi,%rax,4), %zmm0{%k7}{z}
+    vmovdqu32 (%rsi,%rax,4), %zmm1{%k7}{z}
+    \body
+    vmovdqu32 %zmm0, (%rdx,%rax,4){%k7}
+.\name\()_done:
+    vzeroupper
+    ret
+.endm
+
+# floatIsEqual_n_avx512(const unsigned *uf, const unsigned *ug, int *out, size_t n)
+.macro floatIsEqual_consts512
+    broadcast512 0x7FFFFFFF, 8
+    broadcast512 0x7F800000, 9
+    broadcast512 1, 10
+.endm
+.macro floatIsEqual_body512
+    vpandd  %zmm8, %zmm0, %zmm2       # |f|
+    vpandd  %zmm8, %zmm1, %zmm3       # |g|
+    vpcmpeqd %zmm1, %zmm0, %k1        # uf == ug
+    vpord   %zmm3, %zmm2, %zmm4
+    vptestnmd %zmm4, %zmm4, %k2       # both are +0 or -0
+    korw    %k2, %k1, %k1
+    vpcmpgtd %zmm9, %zmm2, %k3        # |f| > inf means f is NaN
+    vpcmpgtd %zmm9, %zmm3, %k4        # |g| > inf means g is NaN
+    korw    %k4, %k3, %k3
+    kandnw  %k1, %k3, %k1             # never equal if either is NaN
+    vmovdqa32 %zmm10, %zmm0{%k1}{z}   # 1 where equal, 0 elsewhere
+.endm
+batch2_512 floatIsEqual_n_avx512, floatIsEqual_body512, floatIsEqual_consts512
+
+# floatScale2_n_avx512(const unsigned *uf, unsigned *out, size_t n)
+.macro floatScale2_consts512
+    broadcast512 0x7FFFFFFF, 8
+    broadcast512 0x00800000, 9
+    broadcast512 0x7F800000, 10
+    broadcast512 0x7F000000, 11
+.endm
+.macro floatScale2_body512
+    vpandd  %zmm8, %zmm0, %zmm1       # |f|
+    vpxord  %zmm1, %zmm0, %zmm2       # sign
+    vpandd  %zmm10, %zmm1, %zmm3      # exponent field
+    vpaddd  %zmm9, %zmm0, %zmm4       # normalized: exp += 1
+    vpcmpeqd %zmm11, %zmm3, %k1       # exp == 0xFE overflows to inf
+    vpord   %zmm10, %zmm2, %zmm4{%k1} # sign | inf
+    vptestnmd %zmm10, %zmm0, %k2      # exp == 0
+    vpslld  $1, %zmm1, %zmm5
+    vpord   %zmm2, %zmm5, %zmm4{%k2}  # denormalized: sign | frac << 1
+    vpcmpeqd %zmm10, %zmm3, %k3       # exp == 0xFF: inf or NaN, unchanged
+    vmovdqa32 %zmm0, %zmm4{%k3}
+    vmovdqa32 %zmm4, %zmm0
+.endm
+batch1_512 floatScale2_n_avx512, floatScale2_body512, floatScale2_consts512
+
+.section .note.GNU-stack,"",@progbits
@@ -0,0 +1,156 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Reductions over arrays of the single-argument puzzles that are
+# predicates: allOddBits, anyEvenBit, isPositive and isPower2. For each
+# puzzle NAME and the n words at x:
+#
+#   size_t count_NAME(const int *x, size_t n)   words NAME is true for
+#   int any_NAME(const int *x, size_t n)        1 if NAME is true for any
+#   int all_NAME(const int *x, size_t n)        1 if NAME is true for all
+#
+# so any_NAME is 0 and all_NAME is 1 when n is 0. any_NAME and all_NAME
+# return as soon as a word decides the answer.
+#
+# Like bits_n.s, the main loop handles 8 words per iteration with AVX2 and
+# the remaining n % 8 one at a time on the low lane of the xmm registers.
+# count_NAME also uses popcnt, which every CPU with AVX2 has. Callers must
+# make sure the CPU supports AVX2 before calling any of these functions.
+
+# The predicates come from bits_macros.inc, which bits_n.s shares. Each
+# turns the words in register 0 into a mask with all ones in the lanes it
+# is true for. The reductions keep zero in register 14 and all ones in
+# register 15, as the predicates expect.
+
+.include "bits_macros.inc"
+
+.macro reduce_consts setup
+    vpxor   %ymm14, %ymm14, %ymm14
+    vpcmpeqd %ymm15, %ymm15, %ymm15
+    \setup
+.endm
+
+# count_NAME: x in %rdi, n in %rsi. The count is kept in %r8
+.macro reduce_count name, pred, setup=no_consts
+.global count_\name
+count_\name:
+    reduce_consts \setup
+    xorl    %eax, %eax                # i = 0
+    xorl    %r8d, %r8d
+    movq    %rsi, %r9
+    andq    $-8, %r9                  # r9 = n rounded down to a multiple of 8
+    jmp     .count_\name\()_vec_check
+.count_\name\()_vec:
+    vmovdqu (%rdi,%rax,4), %ymm0
+    \pred y
+    vmovmskps %ymm0, %ecx             # one bit per lane that is true
+    popcntl %ecx, %ecx
+    addq    %rcx, %r8
+    addq    $8, %rax
+.count_\name\()_vec_check:
+    cmpq    %r9, %rax
+    jb      .count_\name\()_vec
+    jmp     .count_\name\()_tail_check
+.count_\name\()_tail:
+    vmovd   (%rdi,%rax,4), %xmm0
+    \pred x
+    vmovd   %xmm0, %ecx
+    andl    $1, %ecx
+    addq    %rcx, %r8
+    incq    %rax
+.count_\name\()_tail_check:
+    cmpq    %rsi, %rax
+    jb      .count_\name\()_tail
+    movq    %r8, %rax
+    vzeroupper
+    ret
+.endm
+
+# any_NAME: x in %rdi, n in %rsi
+.macro reduce_any name, pred, setup=no_consts
+.global any_\name
+any_\name:
+    reduce_consts \setup
+    xorl    %eax, %eax
+    movq    %rsi, %r9
+    andq    $-8, %r9
+    jmp     .any_\name\()_vec_check
+.any_\name\()_vec:
+    vmovdqu (%rdi,%rax,4), %ymm0
+    \pred y
+    vptest  %ymm0, %ymm0              # ZF clear if any lane is true
+    jnz     .any_\name\()_true
+    addq    $8, %rax
+.any_\name\()_vec_check:
+    cmpq    %r9, %rax
+    jb      .any_\name\()_vec
+    jmp     .any_\name\()_tail_check
+.any_\name\()_tail:
+    vmovd   (%rdi,%rax,4), %xmm0
+    \pred x
+    vmovd   %xmm0, %ecx
+    testl   %ecx, %ecx
+    jnz     .any_\name\()_true
+    incq    %rax
+.any_\name\()_tail_check:
+    cmpq    %rsi, %rax
+    jb      .any_\name\()_tail
+    xorl    %eax, %eax
+    vzeroupper
+    ret
+.any_\name\()_true:
+    movl    $1, %eax
+    vzeroupper
+    ret
+.endm
+
+# all_NAME: x in %rdi, n in %rsi
+.macro reduce_all name, pred, setup=no_consts
+.global all_\name
+all_\name:
+    reduce_consts \setup
+    xorl    %eax, %eax
+    movq    %rsi, %r9
+    andq    $-8, %r9
+    jmp     .all_\name\()_vec_check
+.all_\name\()_vec:
+    vmovdqu (%rdi,%rax,4), %ymm0
+    \pred y
+    vptest  %ymm15, %ymm0             # CF set if every lane is true
+    jnc     .all_\name\()_false
+    addq    $8, %rax
+.all_\name\()_vec_check:
+    cmpq    %r9, %rax
+    jb      .all_\name\()_vec
+    jmp     .all_\name\()_tail_check
+.all_\name\()_tail:
+    vmovd   (%rdi,%rax,4), %xmm0
+    \pred x
+    vmovd   %xmm0, %ecx
+    testl   %ecx, %ecx
+    jz      .all_\name\()_false
+    incq    %rax
+.all_\name\()_tail_check:
+    cmpq    %rsi, %rax
+    jb      .all_\name\()_tail
+    movl    $1, %eax
+    vzeroupper
+    ret
+.all_\name\()_false:
+    xorl    %eax, %eax
+    vzeroupper
+    ret
+.endm
+
+# The three reductions of one predicate
+.macro reductions name, pred, setup=no_consts
+reduce_count \name, \pred, \setup
+reduce_any \name, \pred, \setup
+reduce_all \name, \pred, \setup
+.endm
+
+reductions allOddBits, allOddBits_pred, allOddBits_pred_consts
+reductions anyEvenBit, anyEvenBit_pred, anyEvenBit_pred_consts
+reductions isPositive, isPositive_pred, isPositive_pred_consts
+reductions isPower2, isPower2_pred, isPower2_pred_consts
+
+.section .note.GNU-stack,"",@progbits
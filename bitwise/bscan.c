@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/* Count or test the 32-bit words of a file with one of the predicate puzzles */
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "reduce.h"
+
+/* Values returned by getopt_long() for options without a short form */
+enum {
+    OPT_VERIFY = 256,
+    OPT_TIME,
+};
+
+/*
+ * map_words - Map the file at path into memory, read only, and store
+ * its number of 32-bit words in *n. Returns NULL for an empty file
+ */
+static const int *map_words(const char *path, size_t *n) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Cannot open '%s': %s\n", path, strerror(errno));
+        exit(1);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        printf("Error: Cannot stat '%s': %s\n", path, strerror(errno));
+        exit(1);
+    }
+    if (st.st_size % sizeof(int) != 0) {
+        printf("Error: '%s' is not a whole number of 32-bit words\n", path);
+        exit(1);
+    }
+
+    *n = st.st_size / sizeof(int);
+    const int *words = NULL;
+    if (*n > 0) {
+        // Pages are read in as the scan reaches them, rather than all up
+        // front, so that any and all can stop early without reading the rest
+        words = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (words == MAP_FAILED) {
+            printf("Error: Cannot map '%s': %s\n", path, strerror(errno));
+            exit(1);
+        }
+        madvise((void *) words, st.st_size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    return words;
+}
+
+static void usage(char *prog) {
+    printf("Usage: %s [options] count|any|all puzzle file\n", prog);
+    printf("Print how many of the 32-bit words in file (in native byte order) the\n");
+    printf("puzzle is true for, or 1 or 0 for whether it is true for any or all of them\n");
+    printf("The puzzle is one of:");
+    for (const reduction_t *r = reductions; r->puzzle != NULL; r++) {
+        printf(" %s", r->puzzle);
+    }
+    printf("\n");
+    printf("The scan needs AVX2. On a CPU without it, bscan prints a note instead\n");
+    printf("Options:\n");
+    printf("  -j, --jobs N    Split the scan across N threads (default: all online CPUs)\n");
+    printf("  --verify        Check the result against the puzzle's oracle, called on\n");
+    printf("                  one word at a time\n");
+    printf("  --time          Report the time the scan took and the file size over that\n");
+    printf("                  time, in GB/s, on stderr\n");
+    printf("  -h, --help      Print this message\n");
+}
+
+int main(int argc, char *argv[]) {
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned num_threads = num_cpus > 0 ? num_cpus : 1;
+    bool verify = false;
+    bool timed = false;
+
+    static const struct option long_options[] = {
+        {"jobs", required_argument, NULL, 'j'},
+        {"verify", no_argument, NULL, OPT_VERIFY},
+        {"time", no_argument, NULL, OPT_TIME},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    int c;
+    while ((c = getopt_long(argc, argv, "+hj:", long_options, NULL)) != -1) {
+        switch (c) {
+            case 'h':
+                usage(argv[0]);
+                exit(0);
+
+            case 'j': {
+                char *endp;
+                long n = strtol(optarg, &endp, 10);
+                if (*optarg == '\0' || *endp != '\0' || n < 1 || n > MAX_REDUCE_THREADS) {
+                    printf("Error: -j needs a thread count from 1 to %d\n", MAX_REDUCE_THREADS);
+                    exit(1);
+                }
+                num_threads = n;
+                break;
+            }
+
+            case OPT_VERIFY:
+                verify = true;
+                break;
+
+            case OPT_TIME:
+                timed = true;
+                break;
+
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+    if (argc - optind != 3) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    reduce_op_t op = 0;
+    while (op < NUM_REDUCE_OPS && strcmp(reduce_op_names[op], argv[optind]) != 0) {
+        op++;
+    }
+    if (op == NUM_REDUCE_OPS) {
+        printf("Error: Unknown reduction '%s', expected count, any or all\n", argv[optind]);
+        exit(1);
+    }
+    const reduction_t *r = find_reduction(argv[optind + 1]);
+    if (r == NULL) {
+        printf("Error: '%s' is not a puzzle with reductions\n", argv[optind + 1]);
+        exit(1);
+    }
+    if (num_threads > MAX_REDUCE_THREADS) {
+        num_threads = MAX_REDUCE_THREADS;
+    }
+    if (!__builtin_cpu_supports("avx2")) {
+        // Not a failure of the reductions, just nothing to run them on
+        printf("Skipping the scan, the CPU lacks AVX2\n");
+        return 0;
+    }
+
+    size_t n;
+    const int *words = map_words(argv[optind + 2], &n);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    size_t result = reduce_words(r, op, words, n, num_threads);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("%zu\n", result);
+
+    if (timed) {
+        double elapsed_sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        fprintf(stderr, "%s_%s: %zu words in %.3f s, %.2f GB/s\n", reduce_op_names[op],
+                r->puzzle, n, elapsed_sec,
+                elapsed_sec > 0 ? n * sizeof(int) / elapsed_sec / 1e9 : 0);
+    }
+    if (verify) {
+        size_t expected = reduce_oracle(r, op, words, n);
+        if (result != expected) {
+            printf("ERROR: %s_%s gives %zu. Should be %zu\n", reduce_op_names[op], r->puzzle,
+                   result, expected);
+            exit(1);
+        }
+    }
+    return 0;
+}
@@ -6,14 +6,35 @@
  *
  * Improvements by John Kolb <jhkolb@umn.edu>
  */
+#define _GNU_SOURCE    // For dlvsym()
+#include <dlfcn.h>
+#include <emmintrin.h>
+#include <errno.h>
+#include <fnmatch.h>
+#include <getopt.h>
 #include <limits.h>
+#include <linux/perf_event.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+#include "abi_check.h"
+#include "bits.h"
+#include "dispatch.h"
+#include "libbits.h"
+#include "oracle.h"
 #include "puzzle_spec.h"
+#include "puzzle_table.h"
+#include "reduce.h"
 
 /* For functions with a single argument, generate TEST_RANGE values
    above and below the min and max test values, and above and below
@@ -22,1172 +43,2295 @@
    explosion */
 #define TEST_RANGE 500000
 
-/* This defines the maximum size of any test value array. The
-   gen_vals() routine creates k test values for each value of
-   TEST_RANGE, thus MAX_TEST_VALS must be at least k*TEST_RANGE */
+/* Integer arguments with at most this many possible values are tested
+   on every one of them rather than sampled */
 #define MAX_TEST_VALS 13 * TEST_RANGE
 
+/* Maximum number of test values a generator produces in one step */
+#define MAX_VALS_PER_STEP 12
+
+/* Approximate number of tests a worker thread claims at a time. Large
+   enough to keep contention on the shared chunk counter negligible,
+   small enough that workers notice a mismatch within milliseconds */
+#define SWEEP_CHUNK_TESTS 65536
+
+/* Upper limit on the number of first-argument test values in a chunk,
+   which bounds the size of each worker's buffer for them */
+#define SWEEP_MAX_CHUNK_VALS 4096
+
+/* Number of failing tests listed by --keep-going, unless given, and
+   the most it accepts */
+#define DEFAULT_SHOWN_MISMATCHES 10
+#define MAX_KEPT_MISMATCHES 64
+
+/* Upper limit on the number of worker threads accepted by '-j' */
+#define MAX_THREADS 1024
+
+/* Number of consecutive inputs an exhaustive sweep evaluates and
+   compares at a time */
+#define EXHAUSTIVE_BLOCK 16384
+
+/* Batched implementations are first called on slices of 1, 2, ...,
+   BATCH_MAX_SLICE elements so that every length of their tail (a scalar
+   loop in bits_n.s, one masked iteration in bits_n512.s) is exercised,
+   then on the rest of the inputs at once */
+#define BATCH_MAX_SLICE 17
+
+/* Number of inputs a benchmark times each function on, sampled from
+   the same test values as a sweep. Each sample times BENCH_BLOCK calls
+   in a row, since a single call is shorter than the timer's overhead */
+#define BENCH_INPUTS 4096
+#define BENCH_BLOCK 64
+
+/* Size of each array --throughput streams through, far more than the
+   caches hold, and the number of timed passes over them */
+#define THROUGHPUT_BYTES (64ul << 20)
+#define THROUGHPUT_REPS 10
+
+/* --reduce tests the reductions on arrays of every length up to
+   REDUCE_MAX_SHORT words, and splits a longer one across at least
+   REDUCE_MIN_THREADS threads */
+#define REDUCE_MAX_SHORT (2 * BATCH_MAX_SLICE)
+#define REDUCE_MIN_THREADS 4
+
+/* Passes over the benchmark inputs that are discarded to warm up
+   caches and branch predictors, then passes that are timed */
+#define BENCH_WARMUP_REPS 10
+#define BENCH_REPS 50
+
+/* Width of the puzzle name column in the benchmark reports, enough for
+   names like floatIsEqual_n_avx512 */
+#define NAME_WIDTH 21
+
+/* Most implementations of one puzzle --variants can test: the plain
+   one, its kernel variants and its NAME_auto entry point */
+#define MAX_VARIANTS 8
+
+/* Values returned by getopt_long() for options without a short form */
+enum {
+    OPT_EXHAUSTIVE = 256,
+    OPT_BATCH,
+    OPT_REFERENCE_ORACLE,
+    OPT_BENCH,
+    OPT_SEED,
+    OPT_KEEP_GOING,
+    OPT_ALL,
+    OPT_FORMAT,
+    OPT_ABI_CHECK,
+    OPT_PERF,
+    OPT_BENCH_ORDERS,
+    OPT_VARIANTS,
+    OPT_THROUGHPUT,
+    OPT_REDUCE,
+    OPT_LIBRARY,
+};
+
 extern puzzle_spec_t puzzle_specs[];
 
+/* Settings from the command line that apply to every puzzle tested */
+typedef struct {
+    unsigned num_threads;    // Worker threads used for each sweep, 0 until chosen
+    bool exhaustive;         // Test every possible input instead of sampling
+    bool batch;              // Test each puzzle's batch_func instead of impl_func
+    bool reference;          // Test each puzzle's test_func against its ref_func
+    bool bench;              // Time each puzzle and its oracle instead of testing them
+    bool perf;               // Count hardware events for each puzzle instead of testing it
+    bool bench_orders;       // Time each puzzle on its inputs in several orders
+    unsigned long seed;      // Selects the random test values
+    unsigned max_shown;      // Mismatches listed by --keep-going, 0 to stop at the first
+    bool all;                // Positional arguments are puzzle names or globs
+    bool json;               // Print one JSON object per puzzle instead of text
+    bool abi_check;          // Call impl_func through the abi_call() trampoline
+    bool variants;           // Also test the kernel variants and NAME_auto entry points
+    bool throughput;         // Time each batch_func streaming through large arrays
+    bool reduce;             // Test the count_, any_ and all_ reductions of each predicate
+    const char *library;     // Path of the libbits.so to test instead of the linked-in kernels
+    void *library_handle;    // That library, once opened
+} test_options_t;
+
 /*
- * random_val - Return random integer value between min and max
+ * A function argument given on the command line. Floating point
+ * literals are kept as both a float and a double, and the one matching
+ * the argument's type is used
  */
-static int random_val(int min, int max) {
-    double weight = rand() / (double) RAND_MAX;
-    int result = min * (1 - weight) + max * weight;
-    return result;
+typedef struct {
+    unsigned long val;       // The integer, or the bit pattern of the double
+    unsigned float_val;      // The bit pattern of the float
+    bool is_float;
+} input_arg_t;
+
+/* Kinds of test value sequences a val_gen_t can produce */
+enum gen_kind {
+    GEN_FIXED,     // The single value given on the command line
+    GEN_RANGE,     // Every value from min to max
+    GEN_SAMPLE,    // Values near min, max and zero, plus random ones
+    GEN_FLOAT,     // Bit patterns around interesting float or double values
+};
+
+/* Bit patterns of the interesting values of a floating point format */
+typedef struct {
+    unsigned long smallest_norm;
+    unsigned long one;
+    unsigned long largest_norm;
+    unsigned long inf;
+    unsigned long nan;
+    unsigned long sign;
+} float_format_t;
+
+static const float_format_t float_format = {
+    0x00800000, 0x3f800000, 0x7f000000, 0x7f800000, 0x7fc00000, 0x80000000,
+};
+
+static const float_format_t double_format = {
+    0x0010000000000000, 0x3ff0000000000000, 0x7fe0000000000000,
+    0x7ff0000000000000, 0x7ff8000000000000, 0x8000000000000000,
+};
+
+/* The part of its generator's sequence a test value comes from */
+enum val_region {
+    REGION_FIXED,           // Given on the command line, or an unused argument
+    REGION_RANGE,           // Every value in a small range, or every input
+    REGION_BOUNDARY,        // Near the minimum or maximum value
+    REGION_ZERO,            // Near zero
+    REGION_RANDOM,          // Random, between the minimum and maximum
+    REGION_DENORM,          // Floats: denormalized, near zero
+    REGION_NORM_EDGE,       // Floats: near the smallest normalized value
+    REGION_ONE,             // Floats: near one
+    REGION_LARGEST_NORM,    // Floats: below the largest normalized value
+    REGION_SPECIAL,         // Floats: infinities and NaNs
+    NUM_REGIONS,
+};
+
+static const char *region_names[NUM_REGIONS] = {
+    [REGION_FIXED] = "fixed",
+    [REGION_RANGE] = "full range",
+    [REGION_BOUNDARY] = "boundaries",
+    [REGION_ZERO] = "around zero",
+    [REGION_RANDOM] = "random",
+    [REGION_DENORM] = "denorms",
+    [REGION_NORM_EDGE] = "norm/denorm edge",
+    [REGION_ONE] = "around one",
+    [REGION_LARGEST_NORM] = "largest norm",
+    [REGION_SPECIAL] = "inf/nan",
+};
+
+/*
+ * A resumable generator for the test values of one argument. Values
+ * are produced in steps of at most MAX_VALS_PER_STEP, so a sweep can
+ * generate them a block at a time instead of keeping all of them
+ */
+typedef struct {
+    enum gen_kind kind;
+    long min;
+    long max;
+    int test_range;
+    unsigned long fixed_val;
+    const float_format_t *format;    // Values GEN_FLOAT tests around
+    unsigned long random_key;  // Random stream for GEN_SAMPLE, from the seed and argument
+    unsigned long step;        // Next step to generate
+    unsigned long num_steps;
+} val_gen_t;
+
+/* A test whose implementation result differed from the oracle's */
+typedef struct {
+    unsigned long pos;         // Position of the test in serial sweep order
+    unsigned long args[3];
+    unsigned long actual;
+    unsigned long expected;
+    unsigned abi_errors;       // ABI_* violations, if checked
+} mismatch_t;
+
+/* Mismatches found by one worker thread in a --keep-going sweep */
+typedef struct {
+    unsigned long count;
+    unsigned num_kept;
+    mismatch_t kept[MAX_KEPT_MISMATCHES];    // The first ones found, in serial order
+    unsigned long region_counts[3][NUM_REGIONS];    // By argument and region
+} census_t;
+
+struct sweep;
+
+/*
+ * The state of one thread working on a sweep, including the chunk of
+ * first-argument test values it is currently testing
+ */
+typedef struct {
+    struct sweep *sweep;
+    long *outer_vals;
+    unsigned char *outer_regions;
+    unsigned long chunk_begin;    // Index of outer_vals[0] among the first argument's values
+    unsigned chunk_len;
+    unsigned long abi_sentinels[NUM_ABI_SENTINELS];    // For the chunk, with --abi-check
+    census_t census;
+} worker_t;
+
+/*
+ * A sweep walks the cartesian product of the test values for each
+ * argument, in the same order as three nested loops would. Work is
+ * handed out in chunks of the outermost argument so that several
+ * threads can share one sweep. The outermost argument's values are
+ * generated as chunks are claimed; the other arguments have few enough
+ * values to be generated up front. Unused arguments have exactly one
+ * (ignored) test value so positions in the product stay well-defined.
+ */
+typedef struct sweep {
+    puzzle_spec_t *spec;
+    bool batch;                // Test batch_func rather than impl_func
+    bool reference;            // Test test_func against ref_func rather than impl_func
+    bool keep_going;           // Count every mismatch instead of stopping at the first
+    unsigned max_shown;        // Mismatches listed at the end of a --keep-going sweep
+    bool quiet;                // Leave reporting the outcome to the caller
+    int (*check_range)(worker_t *);    // Generated check_range_NAME loop for spec
+    unsigned long sentinel_key;        // Random stream for the workers' abi_sentinels
+    val_gen_t outer_gen;       // Generator for the first argument's test values
+    long *vals[3];             // Test values for the other arguments, vals[0] is unused
+    unsigned char *regions[3]; // Region of each of those values
+    unsigned num_vals[3];      // num_vals[0] is unused
+    unsigned chunk_size;       // Outer values claimed per chunk
+    pthread_mutex_t gen_lock;  // Guards outer_gen and next_outer
+    unsigned long next_outer;  // Index of the next value outer_gen will produce
+    atomic_uint next_chunk;    // Exhaustive sweeps only: first block not yet claimed
+    atomic_ulong stop_pos;     // Serial position of the earliest mismatch found so far
+    pthread_mutex_t lock;      // Guards failed and fail
+    bool failed;
+    mismatch_t fail;           // The first mismatch in serial sweep order
+    unsigned long num_failed;  // Mismatches found, at most 1 unless keep_going
+    unsigned first_input;      // Exhaustive sweeps only: inputs are first_input,
+    unsigned long num_inputs;  // first_input + 1, ... (modulo 2^32)
+} sweep_t;
+
+/* The outcome of testing one puzzle, for --format=json */
+typedef struct {
+    unsigned long num_tests;   // Tests run, up to the first mismatch unless keep_going
+    unsigned long num_failed;
+    mismatch_t first_fail;     // Only valid if num_failed > 0
+} test_stats_t;
+
+/*
+ * random_bits - Return 64 random bits for position counter of the
+ * random stream identified by key. This is SplitMix64's output function
+ * applied to a counter, so any position of a stream can be computed
+ * directly, by any thread, without shared generator state
+ */
+static unsigned long random_bits(unsigned long key, unsigned long counter) {
+    unsigned long z = key + (counter + 1) * 0x9E3779B97F4A7C15UL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9UL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBUL;
+    return z ^ (z >> 31);
 }
 
 /*
- * gen_vals - Generate the integer values we'll use to test a function
+ * random_val - Return random integer value between min and max, using
+ * the given random bits
  */
-static int gen_vals(int test_vals[], int min, int max, bool is_float_input, int test_range) {
+static long random_val(long min, long max, unsigned long bits) {
+    if (min >= INT_MIN && max <= INT_MAX) {
+        double weight = (bits >> 11) * 0x1.0p-53;    // In [0, 1)
+        int result = min * (1 - weight) + max * weight;
+        return result;
+    }
+    /* A double can't reach every value of a 64-bit range */
+    unsigned long span = (unsigned long) max - (unsigned long) min;
+    if (span == ULONG_MAX) {
+        return (long) bits;
+    }
+    return (long) ((unsigned long) min + bits % (span + 1));
+}
+
+/*
+ * gen_step - Generate the test values for step i of a generator into
+ * out and the region each comes from into regions. Both must have room
+ * for MAX_VALS_PER_STEP values
+ * Returns the number of values generated
+ */
+static unsigned gen_step(const val_gen_t *gen, unsigned long step, long out[],
+                         unsigned char regions[]) {
+#define EMIT(val, region) (out[test_count] = (val), regions[test_count++] = (region))
     int test_count = 0;
+    long min = gen->min;
+    long max = gen->max;
+    int i = step;
+
+    switch (gen->kind) {
+        case GEN_FIXED:
+            EMIT(gen->fixed_val, REGION_FIXED);
+            break;
+
+        case GEN_FLOAT: {
+            /*
+             * Special case: Generate test vals for floating point functions
+             * where the input argument is an unsigned bit-level
+             * representation of a float or double. For this case we want
+             * to test the regions around zero, the smallest normalized and
+             * largest denormalized numbers, one, and the largest normalized
+             * number, as well as inf and nan.
+             */
+            unsigned long smallest_norm = gen->format->smallest_norm;
+            unsigned long one = gen->format->one;
+            unsigned long largest_norm = gen->format->largest_norm;
+
+            unsigned long inf = gen->format->inf;
+            unsigned long nan = gen->format->nan;
+            unsigned long sign = gen->format->sign;
+
+            if (step == gen->test_range) {
+                /* special vals, in the final step */
+                EMIT(inf, REGION_SPECIAL);        /* inf */
+                EMIT(sign | inf, REGION_SPECIAL); /* -inf */
+                EMIT(nan, REGION_SPECIAL);        /* nan */
+                EMIT(sign | nan, REGION_SPECIAL); /* -nan */
+                break;
+            }
+
+            /* The number of tests generated here is the value
+               MAX_VALS_PER_STEP */
+
+            /* Denorms around zero */
+            EMIT(i, REGION_DENORM);
+            EMIT(sign | (unsigned long) i, REGION_DENORM);
+
+            /* Region around norm to denorm transition */
+            EMIT(smallest_norm + i, REGION_NORM_EDGE);
+            EMIT(smallest_norm - i, REGION_NORM_EDGE);
+            EMIT(sign | (smallest_norm + i), REGION_NORM_EDGE);
+            EMIT(sign | (smallest_norm - i), REGION_NORM_EDGE);
 
-    /*
-     * Special case: Generate test vals for floating point functions
-     * where the input argument is an unsigned bit-level
-     * representation of a float. For this case we want to test the
-     * regions around zero, the smallest normalized and largest
-     * denormalized numbers, one, and the largest normalized number,
-     * as well as inf and nan.
-     */
-    if (is_float_input) {
-        unsigned smallest_norm = 0x00800000;
-        unsigned one = 0x3f800000;
-        unsigned largest_norm = 0x7f000000;
-
-        unsigned inf = 0x7f800000;
-        unsigned nan = 0x7fc00000;
-        unsigned sign = 0x80000000;
+            /* Region around one */
+            EMIT(one + i, REGION_ONE);
+            EMIT(one - i, REGION_ONE);
+            EMIT(sign | (one + i), REGION_ONE);
+            EMIT(sign | (one - i), REGION_ONE);
+
+            /* Region below largest norm */
+            EMIT(largest_norm - i, REGION_LARGEST_NORM);
+            EMIT(sign | (largest_norm - i), REGION_LARGEST_NORM);
+            break;
+        }
+
+        case GEN_RANGE:
+            EMIT(min + step, REGION_RANGE);
+            break;
+
+        case GEN_SAMPLE:
+            /* Test around the boundaries */
+            EMIT(min + i, REGION_BOUNDARY);
+            EMIT(max - i, REGION_BOUNDARY);
+
+            /* If zero falls between min and max, then also test around zero */
+            if (i >= min && i <= max) {
+                EMIT(i, REGION_ZERO);
+            }
+            if (-i >= min && -i <= max) {
+                EMIT(-i, REGION_ZERO);
+            }
+
+            /* Random case between min and max */
+            EMIT(random_val(min, max, random_bits(gen->random_key, step)), REGION_RANDOM);
+            break;
+    }
+    return test_count;
+#undef EMIT
+}
 
+/*
+ * val_gen_init - Set up a generator for the integer values we'll use
+ * to test argument arg_index of a function, or for the bit patterns of
+ * values in float_format if it isn't NULL. Its random values depend
+ * only on seed, arg_index and the step they are generated in
+ */
+static void val_gen_init(val_gen_t *gen, long min, long max, const float_format_t *float_format,
+                         int test_range, unsigned long seed, int arg_index) {
+    gen->min = min;
+    gen->max = max;
+    gen->format = float_format;
+    gen->random_key = random_bits(seed, arg_index);
+    gen->step = 0;
+
+    if (float_format != NULL) {
         /* Test range should be at most 1/2 the range of one exponent
            value */
         if (test_range > (1 << 23)) {
             test_range = 1 << 23;
         }
+        gen->kind = GEN_FLOAT;
+        gen->test_range = test_range;
+        gen->num_steps = test_range + 1;
+    } else if (max - MAX_TEST_VALS <= min) {
+        /* If the range is small enough, then do exhaustively */
+        gen->kind = GEN_RANGE;
+        gen->num_steps = (long) max - min + 1;
+    } else {
+        /* Otherwise, need to sample.  Do so near the boundaries, around
+           zero, and for some random cases. */
+        gen->kind = GEN_SAMPLE;
+        gen->test_range = test_range;
+        gen->num_steps = test_range;
+    }
+}
 
-        /* Functions where the input argument is an unsigned bit-level
-           representation of a float. The number of tests generated
-           inside this loop body is the value k referenced in the
-           comment for the global variable MAX_TEST_VALS. */
+/*
+ * val_gen_init_fixed - Set up a generator that produces only val
+ */
+static void val_gen_init_fixed(val_gen_t *gen, unsigned long val) {
+    gen->kind = GEN_FIXED;
+    gen->fixed_val = val;
+    gen->step = 0;
+    gen->num_steps = 1;
+}
 
-        for (int i = 0; i < test_range; i++) {
-            /* Denorms around zero */
-            test_vals[test_count++] = i;
-            test_vals[test_count++] = sign | i;
+/*
+ * val_gen_next - Generate the next test values into out and their
+ * regions into regions, stopping when there is no room for another
+ * step's worth of values
+ * Returns the number of values generated, 0 once the generator is done
+ */
+static unsigned val_gen_next(val_gen_t *gen, long out[], unsigned char regions[],
+                             unsigned max_vals) {
+    unsigned n = 0;
+    while (gen->step < gen->num_steps && n + MAX_VALS_PER_STEP <= max_vals) {
+        n += gen_step(gen, gen->step++, out + n, regions + n);
+    }
+    return n;
+}
 
-            /* Region around norm to denorm transition */
-            test_vals[test_count++] = smallest_norm + i;
-            test_vals[test_count++] = smallest_norm - i;
-            test_vals[test_count++] = sign | (smallest_norm + i);
-            test_vals[test_count++] = sign | (smallest_norm - i);
+/*
+ * val_gen_count - Return the total number of values a generator
+ * produces from its first step, without generating them
+ */
+static unsigned long val_gen_count(const val_gen_t *gen) {
+    switch (gen->kind) {
+        case GEN_FLOAT:
+            return MAX_VALS_PER_STEP * (unsigned long) gen->test_range + 4;
+
+        case GEN_SAMPLE: {
+            unsigned long count = 0;
+            for (int i = 0; i < gen->test_range; i++) {
+                count += 3;
+                count += i >= gen->min && i <= gen->max;
+                count += -i >= gen->min && -i <= gen->max;
+            }
+            return count;
+        }
 
-            /* Region around one */
-            test_vals[test_count++] = one + i;
-            test_vals[test_count++] = one - i;
-            test_vals[test_count++] = sign | (one + i);
-            test_vals[test_count++] = sign | (one - i);
+        default:
+            return gen->num_steps;
+    }
+}
 
-            /* Region below largest norm */
-            test_vals[test_count++] = largest_norm - i;
-            test_vals[test_count++] = sign | (largest_norm - i);
+/*
+ * val_gen_all - Generate all remaining values of a generator into a
+ * newly allocated array, and store their number in *count and their
+ * regions in a newly allocated *regions
+ */
+static long *val_gen_all(val_gen_t *gen, unsigned *count, unsigned char **regions) {
+    unsigned max_vals = val_gen_count(gen) + MAX_VALS_PER_STEP;
+    long *vals = malloc(max_vals * sizeof(long));
+    *regions = malloc(max_vals);
+    if (vals == NULL || *regions == NULL) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    *count = 0;
+    unsigned n;
+    while ((n = val_gen_next(gen, vals + *count, *regions + *count, max_vals - *count)) > 0) {
+        *count += n;
+    }
+    return vals;
+}
+
+/*
+ * sweep_record - Record a mismatch. Only the mismatch a serial sweep
+ * would encounter first is kept
+ */
+static void sweep_record(sweep_t *sweep, const mismatch_t *mismatch) {
+    pthread_mutex_lock(&sweep->lock);
+    if (!sweep->failed || mismatch->pos < sweep->fail.pos) {
+        sweep->failed = true;
+        sweep->fail = *mismatch;
+        atomic_store(&sweep->stop_pos, mismatch->pos);
+    }
+    pthread_mutex_unlock(&sweep->lock);
+}
+
+/*
+ * census_add - Count a mismatch in a worker's census, whose arguments
+ * came from the given regions. A worker claims chunks in serial order,
+ * so the first mismatches it finds are the ones worth keeping
+ */
+static void census_add(census_t *census, const mismatch_t *mismatch,
+                       const unsigned char regions[3]) {
+    census->count++;
+    if (census->num_kept < MAX_KEPT_MISMATCHES) {
+        census->kept[census->num_kept++] = *mismatch;
+    }
+    for (int i = 0; i < 3; i++) {
+        census->region_counts[i][regions[i]]++;
+    }
+}
+
+/*
+ * sweep_report - Report a mismatch found at index i of the worker's
+ * chunk and indexes j and k of the other arguments' test values
+ * Returns true if the worker should stop testing its chunk
+ */
+static bool sweep_report(worker_t *worker, unsigned i, unsigned j, unsigned k,
+                         unsigned long arg1, unsigned long arg2, unsigned long arg3,
+                         unsigned long actual, unsigned long expected, unsigned abi_errors) {
+    sweep_t *sweep = worker->sweep;
+    mismatch_t mismatch = {
+        .pos = ((worker->chunk_begin + i) * sweep->num_vals[1] + j) * sweep->num_vals[2] + k,
+        .args = {arg1, arg2, arg3},
+        .actual = actual,
+        .expected = expected,
+        .abi_errors = abi_errors,
+    };
+    if (sweep->keep_going) {
+        unsigned char regions[3] = {
+            worker->outer_regions[i],
+            sweep->regions[1][j],
+            sweep->regions[2][k],
+        };
+        census_add(&worker->census, &mismatch, regions);
+        return false;
+    }
+    sweep_record(sweep, &mismatch);
+    return true;
+}
+
+/*
+ * How the generated loops call the implementation: directly, through
+ * the spec's impl_func when that is a variant of the puzzle, or through
+ * the abi_call() trampoline with the worker's sentinels. Unused
+ * trailing arguments of the trampoline are passed as 0
+ */
+#define DIRECT_CALL(name, abi_errors, sentinels, ...) name(__VA_ARGS__)
+#define INDIRECT_CALL(name, abi_errors, sentinels, ...)                                    \
+    ((__typeof__(&name)) worker->sweep->spec->impl_func)(__VA_ARGS__)
+#define ABI_ARGS(arg1, arg2, arg3, ...) arg1, arg2, arg3
+#define ABI_CALL(name, abi_errors, sentinels, ...)                                         \
+    abi_call(ABI_ARGS(__VA_ARGS__, 0, 0, 0), worker->sweep->spec->impl_func, sentinels,   \
+             &abi_errors)
+
+/*
+ * check_range_NAME - Test every combination of arguments whose first
+ * argument is one of the test values in the worker's current chunk
+ * Returns -1 if it stopped at a mismatch and 0 otherwise
+ *
+ * One of these is generated per puzzle from FOR_EACH_PUZZLE. The
+ * implementation and the oracle are called directly with the puzzle's
+ * own argument types, so the compiler can inline the oracle into the
+ * loop instead of making two indirect calls per test. Mismatches are
+ * handled out of line, so a --keep-going sweep runs the same loop
+ *
+ * check_indirect_range_NAME is the same loop for the variants of the
+ * puzzle, calling whichever one is the spec's impl_func, and
+ * check_abi_range_NAME the one for --abi-check, calling it through
+ * abi_call() so that every test also checks the calling convention
+ */
+#define DEFINE_CHECK_LOOP_1(func, name, CALL, ret_t, arg1_t)                               \
+    static int func(worker_t *worker) {                                                   \
+        const long *outer_vals = worker->outer_vals;                                      \
+        unsigned n = worker->chunk_len;                                                   \
+        for (unsigned i = 0; i < n; i++) {                                                \
+            arg1_t arg1 = outer_vals[i];                                                  \
+            unsigned abi_errors = 0;                                                      \
+            ret_t actual = CALL(name, abi_errors, worker->abi_sentinels, arg1);           \
+            ret_t expected = test_##name(arg1);                                           \
+            if ((actual != expected || abi_errors != 0) &&                                \
+                sweep_report(worker, i, 0, 0, arg1, 0, 0, actual, expected,               \
+                             abi_errors)) {                                               \
+                return -1;                                                                \
+            }                                                                             \
+        }                                                                                 \
+        return 0;                                                                         \
+    }
+
+#define DEFINE_CHECK_LOOP_2(func, name, CALL, ret_t, arg1_t, arg2_t)                       \
+    static int func(worker_t *worker) {                                                   \
+        const long *outer_vals = worker->outer_vals;                                      \
+        unsigned n = worker->chunk_len;                                                   \
+        long **vals = worker->sweep->vals;                                                \
+        unsigned num_vals1 = worker->sweep->num_vals[1];                                  \
+        for (unsigned i = 0; i < n; i++) {                                                \
+            arg1_t arg1 = outer_vals[i];                                                  \
+            for (unsigned j = 0; j < num_vals1; j++) {                                    \
+                arg2_t arg2 = vals[1][j];                                                 \
+                unsigned abi_errors = 0;                                                  \
+                ret_t actual = CALL(name, abi_errors, worker->abi_sentinels, arg1, arg2); \
+                ret_t expected = test_##name(arg1, arg2);                                 \
+                if ((actual != expected || abi_errors != 0) &&                            \
+                    sweep_report(worker, i, j, 0, arg1, arg2, 0, actual, expected,        \
+                                 abi_errors)) {                                           \
+                    return -1;                                                            \
+                }                                                                         \
+            }                                                                             \
+        }                                                                                 \
+        return 0;                                                                         \
+    }
+
+#define DEFINE_CHECK_LOOP_3(func, name, CALL, ret_t, arg1_t, arg2_t, arg3_t)               \
+    static int func(worker_t *worker) {                                                   \
+        const long *outer_vals = worker->outer_vals;                                      \
+        unsigned n = worker->chunk_len;                                                   \
+        long **vals = worker->sweep->vals;                                                \
+        unsigned num_vals1 = worker->sweep->num_vals[1];                                  \
+        unsigned num_vals2 = worker->sweep->num_vals[2];                                  \
+        for (unsigned i = 0; i < n; i++) {                                                \
+            arg1_t arg1 = outer_vals[i];                                                  \
+            for (unsigned j = 0; j < num_vals1; j++) {                                    \
+                arg2_t arg2 = vals[1][j];                                                 \
+                for (unsigned k = 0; k < num_vals2; k++) {                                \
+                    arg3_t arg3 = vals[2][k];                                             \
+                    unsigned abi_errors = 0;                                              \
+                    ret_t actual =                                                        \
+                        CALL(name, abi_errors, worker->abi_sentinels, arg1, arg2, arg3);  \
+                    ret_t expected = test_##name(arg1, arg2, arg3);                       \
+                    if ((actual != expected || abi_errors != 0) &&                        \
+                        sweep_report(worker, i, j, k, arg1, arg2, arg3, actual,           \
+                                     expected, abi_errors)) {                             \
+                        return -1;                                                        \
+                    }                                                                     \
+                }                                                                         \
+            }                                                                             \
+        }                                                                                 \
+        return 0;                                                                         \
+    }
+
+#define DEFINE_CHECK_RANGE_1(name, ...)                                                    \
+    DEFINE_CHECK_LOOP_1(check_range_##name, name, DIRECT_CALL, __VA_ARGS__)               \
+    DEFINE_CHECK_LOOP_1(check_indirect_range_##name, name, INDIRECT_CALL, __VA_ARGS__)    \
+    DEFINE_CHECK_LOOP_1(check_abi_range_##name, name, ABI_CALL, __VA_ARGS__)
+#define DEFINE_CHECK_RANGE_2(name, ...)                                                    \
+    DEFINE_CHECK_LOOP_2(check_range_##name, name, DIRECT_CALL, __VA_ARGS__)               \
+    DEFINE_CHECK_LOOP_2(check_indirect_range_##name, name, INDIRECT_CALL, __VA_ARGS__)    \
+    DEFINE_CHECK_LOOP_2(check_abi_range_##name, name, ABI_CALL, __VA_ARGS__)
+#define DEFINE_CHECK_RANGE_3(name, ...)                                                    \
+    DEFINE_CHECK_LOOP_3(check_range_##name, name, DIRECT_CALL, __VA_ARGS__)               \
+    DEFINE_CHECK_LOOP_3(check_indirect_range_##name, name, INDIRECT_CALL, __VA_ARGS__)    \
+    DEFINE_CHECK_LOOP_3(check_abi_range_##name, name, ABI_CALL, __VA_ARGS__)
+
+FOR_EACH_PUZZLE(DEFINE_CHECK_RANGE_1, DEFINE_CHECK_RANGE_2, DEFINE_CHECK_RANGE_3)
+
+typedef int check_range_func_t(worker_t *);
+
+#define RANGE_CHECKER_ENTRY(name, ...)                                                     \
+    {(int (*)(void)) test_##name, (int (*)(void)) name, check_range_##name,                \
+     check_indirect_range_##name, check_abi_range_##name},
+
+/*
+ * The generated check_range_NAME loops for each puzzle, by oracle, so
+ * that the variants of a puzzle find its loops too
+ */
+static const struct {
+    int (*test_func)(void);
+    int (*impl_func)(void);
+    check_range_func_t *check_range;
+    check_range_func_t *check_indirect_range;
+    check_range_func_t *check_abi_range;
+} range_checkers[] = {
+    FOR_EACH_PUZZLE(RANGE_CHECKER_ENTRY, RANGE_CHECKER_ENTRY, RANGE_CHECKER_ENTRY)
+};
+
+/*
+ * find_range_checker - Look up the generated check_range_NAME loop for
+ * a puzzle, its check_indirect_range_NAME loop if spec is a variant
+ * with its own impl_func, or its check_abi_range_NAME loop if abi_check
+ * is set
+ */
+static check_range_func_t *find_range_checker(puzzle_spec_t *spec, bool abi_check) {
+    for (size_t i = 0; i < sizeof(range_checkers) / sizeof(range_checkers[0]); i++) {
+        if (range_checkers[i].test_func != spec->test_func) {
+            continue;
+        }
+        if (abi_check) {
+            return range_checkers[i].check_abi_range;
+        }
+        if (range_checkers[i].impl_func != spec->impl_func) {
+            return range_checkers[i].check_indirect_range;
+        }
+        return range_checkers[i].check_range;
+    }
+    printf("Error: Puzzle '%s' is missing from FOR_EACH_PUZZLE in puzzle_table.h\n", spec->name);
+    exit(1);
+}
+
+/*
+ * first_difference - Return the index of the first position where a and
+ * b differ, or n if they are identical. Four values are compared per
+ * SSE2 instruction
+ */
+static unsigned first_difference(const unsigned a[], const unsigned b[], unsigned n) {
+    unsigned i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i va = _mm_loadu_si128((const __m128i *) &a[i]);
+        __m128i vb = _mm_loadu_si128((const __m128i *) &b[i]);
+        int equal_bytes = _mm_movemask_epi8(_mm_cmpeq_epi32(va, vb));
+        if (equal_bytes != 0xFFFF) {
+            return i + __builtin_ctz(~equal_bytes) / 4;
+        }
+    }
+    for (; i < n; i++) {
+        if (a[i] != b[i]) {
+            return i;
+        }
+    }
+    return n;
+}
+
+/* Signatures of batched implementations with one, two and three input arrays */
+typedef void batch1_func_t(const unsigned *, unsigned *, size_t);
+typedef void batch2_func_t(const unsigned *, const unsigned *, unsigned *, size_t);
+typedef void batch3_func_t(const unsigned *, const unsigned *, const unsigned *, unsigned *,
+                           size_t);
+
+/*
+ * call_batch - Run a puzzle's batched implementation on count inputs
+ */
+static void call_batch(puzzle_spec_t *spec, unsigned *args[3], unsigned out[], size_t count) {
+    switch (spec->num_args) {
+        case 1: {
+            batch1_func_t *batch = (batch1_func_t *) spec->batch_func;
+            batch(args[0], out, count);
+            break;
+        }
+
+        case 2: {
+            batch2_func_t *batch = (batch2_func_t *) spec->batch_func;
+            batch(args[0], args[1], out, count);
+            break;
+        }
+
+        case 3: {
+            batch3_func_t *batch = (batch3_func_t *) spec->batch_func;
+            batch(args[0], args[1], args[2], out, count);
+            break;
+        }
+
+        default:
+            printf("Error: No batched implementation for test case '%s'\n", spec->name);
+            exit(1);
+    }
+}
+
+/*
+ * eval_func - Compute the results of func (one of the puzzle's
+ * impl_func, test_func or ref_func) for count inputs laid out as
+ * arrays. Every puzzle argument and result is a 32-bit integer passed
+ * in a general-purpose register, so func can be called through an
+ * unsigned signature whatever the signedness of its parameters
+ */
+static void eval_func(puzzle_spec_t *spec, int (*func)(void), unsigned *args[3], unsigned out[],
+                      unsigned count) {
+    switch (spec->num_args) {
+        case 1: {
+            unsigned (*f)(unsigned) = (unsigned (*)(unsigned)) func;
+            for (unsigned i = 0; i < count; i++) {
+                out[i] = f(args[0][i]);
+            }
+            break;
+        }
+
+        case 2: {
+            unsigned (*f)(unsigned, unsigned) = (unsigned (*)(unsigned, unsigned)) func;
+            for (unsigned i = 0; i < count; i++) {
+                out[i] = f(args[0][i], args[1][i]);
+            }
+            break;
+        }
+
+        case 3: {
+            unsigned (*f)(unsigned, unsigned, unsigned) =
+                (unsigned (*)(unsigned, unsigned, unsigned)) func;
+            for (unsigned i = 0; i < count; i++) {
+                out[i] = f(args[0][i], args[1][i], args[2][i]);
+            }
+            break;
+        }
+
+        default:
+            printf("Error: Invalid number of arguments for test case '%s'\n", spec->name);
+            exit(1);
+    }
+}
+
+/*
+ * check_array_range - Like check_range_NAME, but lays the same argument
+ * combinations out as arrays. Tests the puzzle's batched implementation
+ * against its oracle or, for a reference sweep, the oracle against the
+ * reference oracle
+ * Returns -1 if it stopped at a mismatch and 0 otherwise
+ */
+static int check_array_range(worker_t *worker) {
+    sweep_t *sweep = worker->sweep;
+    puzzle_spec_t *spec = sweep->spec;
+    unsigned *num_vals = sweep->num_vals;
+    unsigned inner_tests = num_vals[1] * num_vals[2];
+    unsigned count = worker->chunk_len * inner_tests;
+
+    unsigned *buf = malloc(5 * sizeof(unsigned) * count);
+    if (buf == NULL) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    unsigned *args[3] = {buf, buf + count, buf + 2 * count};
+    unsigned *actual = buf + 3 * count;
+    unsigned *expected = buf + 4 * count;
+
+    unsigned pos = 0;
+    for (int i = 0; i < worker->chunk_len; i++) {
+        for (int j = 0; j < num_vals[1]; j++) {
+            for (int k = 0; k < num_vals[2]; k++) {
+                args[0][pos] = worker->outer_vals[i];
+                args[1][pos] = sweep->vals[1][j];
+                args[2][pos] = sweep->vals[2][k];
+                pos++;
+            }
+        }
+    }
+
+    if (sweep->reference) {
+        eval_func(spec, spec->test_func, args, actual, count);
+        eval_func(spec, spec->ref_func, args, expected, count);
+    } else {
+        unsigned done = 0;
+        for (unsigned len = 1; done < count; len++) {
+            unsigned slice = len <= BATCH_MAX_SLICE ? len : count - done;
+            if (slice > count - done) {
+                slice = count - done;
+            }
+            unsigned *slice_args[3] = {args[0] + done, args[1] + done, args[2] + done};
+            call_batch(spec, slice_args, actual + done, slice);
+            done += slice;
+        }
+        eval_func(spec, spec->test_func, args, expected, count);
+    }
+
+    int result = 0;
+    for (unsigned i = first_difference(actual, expected, count); i < count;
+         i += 1 + first_difference(actual + i + 1, expected + i + 1, count - i - 1)) {
+        if (sweep_report(worker, i / inner_tests, i / num_vals[2] % num_vals[1],
+                         i % num_vals[2], args[0][i], args[1][i], args[2][i], actual[i],
+                         expected[i], 0)) {
+            result = -1;
+            break;
+        }
+    }
+    free(buf);
+    return result;
+}
+
+/*
+ * sweep_claim - Generate the next chunk of first-argument test values
+ * into the worker's buffers
+ * Returns the number of values in the chunk, 0 once there are none left
+ */
+static unsigned sweep_claim(worker_t *worker) {
+    sweep_t *sweep = worker->sweep;
+    pthread_mutex_lock(&sweep->gen_lock);
+    worker->chunk_begin = sweep->next_outer;
+    worker->chunk_len = val_gen_next(&sweep->outer_gen, worker->outer_vals,
+                                     worker->outer_regions, sweep->chunk_size);
+    sweep->next_outer += worker->chunk_len;
+    pthread_mutex_unlock(&sweep->gen_lock);
+    return worker->chunk_len;
+}
+
+/*
+ * sweep_worker - Claim chunks of the sweep until none are left or a
+ * mismatch makes the remaining chunks irrelevant
+ */
+static void *sweep_worker(void *arg) {
+    worker_t *worker = arg;
+    sweep_t *sweep = worker->sweep;
+    unsigned long inner_tests = sweep->num_vals[1] * sweep->num_vals[2];
+    worker->outer_vals = malloc(sweep->chunk_size * sizeof(long));
+    worker->outer_regions = malloc(sweep->chunk_size);
+    if (worker->outer_vals == NULL || worker->outer_regions == NULL) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+
+    /* Chunks after the earliest known mismatch cannot change which
+       mismatch gets reported, so there is no need to test them */
+    while (sweep_claim(worker) > 0 &&
+           worker->chunk_begin * inner_tests <= atomic_load(&sweep->stop_pos)) {
+        /* Fresh sentinels for each chunk, derived from its position so
+           that a sweep checks with the same values however it is split */
+        for (int r = 0; r < NUM_ABI_SENTINELS; r++) {
+            worker->abi_sentinels[r] =
+                random_bits(sweep->sentinel_key, worker->chunk_begin * NUM_ABI_SENTINELS + r);
+        }
+        if (sweep->batch || sweep->reference) {
+            check_array_range(worker);
+        } else {
+            sweep->check_range(worker);
+        }
+    }
+    free(worker->outer_vals);
+    free(worker->outer_regions);
+    return NULL;
+}
+
+/*
+ * eval_block - Evaluate a single-argument puzzle function on the n
+ * consecutive inputs starting at first
+ */
+static void eval_block(puzzle_spec_t *spec, int (*func)(void), unsigned first, unsigned out[],
+                       unsigned n) {
+    switch (spec->return_type) {
+        case INT_RET:
+            if (spec->arg_types[0] == INT_ARG) {
+                int (*f)(int) = (int (*)(int)) func;
+                for (unsigned i = 0; i < n; i++) {
+                    out[i] = f(first + i);
+                }
+            } else {
+                int (*f)(unsigned) = (int (*)(unsigned)) func;
+                for (unsigned i = 0; i < n; i++) {
+                    out[i] = f(first + i);
+                }
+            }
+            break;
+
+        case UNSIGNED_RET:
+            if (spec->arg_types[0] == INT_ARG) {
+                unsigned (*f)(int) = (unsigned (*)(int)) func;
+                for (unsigned i = 0; i < n; i++) {
+                    out[i] = f(first + i);
+                }
+            } else {
+                unsigned (*f)(unsigned) = (unsigned (*)(unsigned)) func;
+                for (unsigned i = 0; i < n; i++) {
+                    out[i] = f(first + i);
+                }
+            }
+            break;
+
+        default:
+            printf("Error: Exhaustive testing is only supported for 32-bit puzzles\n");
+            exit(1);
+    }
+}
+
+/*
+ * exhaustive_worker - Claim blocks of consecutive inputs and compare
+ * the implementation against the oracle on each of them
+ */
+static void *exhaustive_worker(void *arg) {
+    worker_t *worker = arg;
+    sweep_t *sweep = worker->sweep;
+    puzzle_spec_t *spec = sweep->spec;
+    unsigned actual[EXHAUSTIVE_BLOCK];
+    unsigned expected[EXHAUSTIVE_BLOCK];
+    const unsigned char regions[3] = {REGION_RANGE, REGION_FIXED, REGION_FIXED};
+
+    while (true) {
+        unsigned long begin =
+            (unsigned long) atomic_fetch_add(&sweep->next_chunk, 1) * EXHAUSTIVE_BLOCK;
+        if (begin >= sweep->num_inputs || begin > atomic_load(&sweep->stop_pos)) {
+            return NULL;
+        }
+        unsigned n = EXHAUSTIVE_BLOCK;
+        if (begin + n > sweep->num_inputs) {
+            n = sweep->num_inputs - begin;
+        }
+
+        unsigned first = sweep->first_input + begin;
+        if (sweep->batch) {
+            // In place, the way a buffer of floats is rescaled
+            for (unsigned i = 0; i < n; i++) {
+                actual[i] = first + i;
+            }
+            unsigned *args[3] = {actual, NULL, NULL};
+            call_batch(spec, args, actual, n);
+            eval_block(spec, spec->test_func, first, expected, n);
+        } else if (sweep->reference) {
+            eval_block(spec, spec->test_func, first, actual, n);
+            eval_block(spec, spec->ref_func, first, expected, n);
+        } else {
+            eval_block(spec, spec->impl_func, first, actual, n);
+            eval_block(spec, spec->test_func, first, expected, n);
+        }
+        for (unsigned i = first_difference(actual, expected, n); i < n;
+             i += 1 + first_difference(actual + i + 1, expected + i + 1, n - i - 1)) {
+            mismatch_t mismatch = {
+                .pos = begin + i,
+                .args = {first + i, 0, 0},
+                .actual = actual[i],
+                .expected = expected[i],
+            };
+            if (!sweep->keep_going) {
+                sweep_record(sweep, &mismatch);
+                return NULL;
+            }
+            census_add(&worker->census, &mismatch, regions);
+        }
+    }
+}
+
+/*
+ * Whether an argument or return type is signed, and whether it is 64
+ * bits wide. Values of every type are carried around as unsigned longs
+ */
+static bool arg_is_signed(enum argType type) {
+    return type == INT_ARG || type == LONG_ARG;
+}
+
+static bool arg_is_64bit(enum argType type) {
+    return type == LONG_ARG || type == DOUBLE_AS_ULONG_ARG;
+}
+
+static bool ret_is_signed(enum returnType type) {
+    return type == INT_RET || type == LONG_RET;
+}
+
+static bool ret_is_64bit(enum returnType type) {
+    return type == LONG_RET || type == UNSIGNED_LONG_RET;
+}
+
+/*
+ * puzzle_is_64bit - Return true if any argument or the result of spec
+ * is 64 bits wide. Only the generated check_range_NAME loops can test
+ * these; the exhaustive, batched and benchmark paths pass 32-bit values
+ */
+static bool puzzle_is_64bit(const puzzle_spec_t *spec) {
+    for (int i = 0; i < spec->num_args; i++) {
+        if (arg_is_64bit(spec->arg_types[i])) {
+            return true;
         }
+    }
+    return ret_is_64bit(spec->return_type);
+}
+
+/*
+ * print_value - Print a test value or result in decimal and hex
+ */
+static void print_value(unsigned long val, bool is_signed, bool is_64bit) {
+    if (is_64bit && is_signed) {
+        printf("%ld[0x%lx]", (long) val, val);
+    } else if (is_64bit) {
+        printf("%lu[0x%lx]", val, val);
+    } else if (is_signed) {
+        printf("%d[0x%x]", (int) val, (unsigned) val);
+    } else {
+        printf("%u[0x%x]", (unsigned) val, (unsigned) val);
+    }
+}
+
+/* Descriptions of the ABI_* violations, by bit number */
+static const char *abi_violation_names[NUM_ABI_VIOLATIONS] = {
+    "%rbx not preserved",
+    "%rbp not preserved",
+    "%r12 not preserved",
+    "%r13 not preserved",
+    "%r14 not preserved",
+    "%r15 not preserved",
+    "wrote to the caller's frame above the return address",
+    "wrote more than 128 bytes below %rsp, past the red zone",
+    "returned with the direction flag set",
+    "changed the MXCSR control bits",
+    "changed the x87 control word",
+};
 
-        /* special vals */
-        test_vals[test_count++] = inf;        /* inf */
-        test_vals[test_count++] = sign | inf; /* -inf */
-        test_vals[test_count++] = nan;        /* nan */
-        test_vals[test_count++] = sign | nan; /* -nan */
+/*
+ * print_mismatch - Describe a mismatch found while testing spec
+ */
+static void print_mismatch(const puzzle_spec_t *spec, const mismatch_t *mismatch) {
+    bool signed_ret = ret_is_signed(spec->return_type);
+    bool wide_ret = ret_is_64bit(spec->return_type);
 
-        return test_count;
+    printf("ERROR: Test %s(", spec->name);
+    for (int i = 0; i < spec->num_args; i++) {
+        if (i > 0) {
+            printf(",");
+        }
+        print_value(mismatch->args[i], arg_is_signed(spec->arg_types[i]),
+                    arg_is_64bit(spec->arg_types[i]));
+    }
+    printf(") failed...\n");
+    if (mismatch->actual != mismatch->expected) {
+        printf("...Gives ");
+        print_value(mismatch->actual, signed_ret, wide_ret);
+        printf(". Should be ");
+        print_value(mismatch->expected, signed_ret, wide_ret);
+        printf("\n");
+    }
+    for (int i = 0; i < NUM_ABI_VIOLATIONS; i++) {
+        if (mismatch->abi_errors & (1u << i)) {
+            printf("...Calling convention broken: %s\n", abi_violation_names[i]);
+        }
+    }
+}
+
+/*
+ * compare_mismatches - qsort() comparison function that orders
+ * mismatches by position in serial sweep order
+ */
+static int compare_mismatches(const void *a, const void *b) {
+    unsigned long x = ((const mismatch_t *) a)->pos;
+    unsigned long y = ((const mismatch_t *) b)->pos;
+    return (x > y) - (x < y);
+}
+
+/*
+ * merge_census - Combine the censuses of a --keep-going sweep's workers
+ * into the sweep's outcome, then print the first mismatches, the total
+ * and the count per region unless the sweep is quiet
+ */
+static void merge_census(sweep_t *sweep, const worker_t workers[], unsigned num_workers) {
+    puzzle_spec_t *spec = sweep->spec;
+    unsigned long total = 0;
+    unsigned long region_counts[3][NUM_REGIONS] = {{0}};
+    mismatch_t *kept = malloc(num_workers * sizeof(workers[0].census.kept));
+    unsigned num_kept = 0;
+    if (kept == NULL) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+
+    for (unsigned w = 0; w < num_workers; w++) {
+        const census_t *census = &workers[w].census;
+        total += census->count;
+        for (unsigned i = 0; i < census->num_kept; i++) {
+            kept[num_kept++] = census->kept[i];
+        }
+        for (int arg = 0; arg < 3; arg++) {
+            for (int r = 0; r < NUM_REGIONS; r++) {
+                region_counts[arg][r] += census->region_counts[arg][r];
+            }
+        }
+    }
+
+    /* Every worker kept the first mismatches it found, so the first
+       mismatches of the whole sweep are among them */
+    qsort(kept, num_kept, sizeof(kept[0]), compare_mismatches);
+    sweep->num_failed = total;
+    if (num_kept > 0) {
+        sweep->failed = true;
+        sweep->fail = kept[0];
+    }
+    for (unsigned i = 0; i < num_kept && i < sweep->max_shown && !sweep->quiet; i++) {
+        print_mismatch(spec, &kept[i]);
+    }
+    free(kept);
+
+    if (total > 0 && !sweep->quiet) {
+        printf("...%s failed %lu tests in total\n", spec->name, total);
+        for (int arg = 0; arg < spec->num_args; arg++) {
+            printf("...Failures by region of argument %d:", arg + 1);
+            const char *sep = " ";
+            for (int r = 0; r < NUM_REGIONS; r++) {
+                if (region_counts[arg][r] > 0) {
+                    printf("%s%s %lu", sep, region_names[r], region_counts[arg][r]);
+                    sep = ", ";
+                }
+            }
+            printf("\n");
+        }
+    }
+}
+
+/*
+ * run_sweep - Run worker on num_threads threads, including the calling
+ * thread, and report the outcome of the sweep unless it is quiet
+ * Returns 0 on success and -1 on failure
+ */
+static int run_sweep(sweep_t *sweep, unsigned num_threads, void *(*worker)(void *)) {
+    pthread_t threads[MAX_THREADS];
+    unsigned num_started = 0;
+    worker_t *workers = calloc(num_threads, sizeof(worker_t));
+    if (workers == NULL) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    for (unsigned i = 0; i < num_threads; i++) {
+        workers[i].sweep = sweep;
+    }
+
+    unsigned inner_tests = sweep->num_vals[1] * sweep->num_vals[2];
+    sweep->chunk_size = SWEEP_CHUNK_TESTS / inner_tests;
+    if (sweep->chunk_size < MAX_VALS_PER_STEP) {
+        // Leave room for at least one generator step
+        sweep->chunk_size = MAX_VALS_PER_STEP;
+    } else if (sweep->chunk_size > SWEEP_MAX_CHUNK_VALS) {
+        sweep->chunk_size = SWEEP_MAX_CHUNK_VALS;
+    }
+    sweep->next_outer = 0;
+    atomic_init(&sweep->next_chunk, 0);
+    atomic_init(&sweep->stop_pos, ULONG_MAX);
+    pthread_mutex_init(&sweep->gen_lock, NULL);
+    pthread_mutex_init(&sweep->lock, NULL);
+    sweep->failed = false;
+    sweep->num_failed = 0;
+
+    // The calling thread uses workers[0]
+    while (num_started + 1 < num_threads) {
+        if (pthread_create(&threads[num_started], NULL, worker, &workers[num_started + 1]) !=
+            0) {
+            // Carry on with the threads we were able to start
+            break;
+        }
+        num_started++;
+    }
+    worker(&workers[0]);
+    for (unsigned i = 0; i < num_started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&sweep->gen_lock);
+    pthread_mutex_destroy(&sweep->lock);
+
+    if (sweep->keep_going) {
+        merge_census(sweep, workers, num_started + 1);
+    } else if (sweep->failed) {
+        sweep->num_failed = 1;
+        if (!sweep->quiet) {
+            print_mismatch(sweep->spec, &sweep->fail);
+        }
+    }
+    free(workers);
+    return sweep->failed ? -1 : 0;
+}
+
+/*
+ * sweep_stats - Fill in stats from a finished sweep of num_tests tests
+ */
+static void sweep_stats(const sweep_t *sweep, unsigned long num_tests, test_stats_t *stats) {
+    stats->num_tests = num_tests;
+    stats->num_failed = sweep->num_failed;
+    if (sweep->failed) {
+        stats->first_fail = sweep->fail;
+        if (!sweep->keep_going) {
+            stats->num_tests = sweep->fail.pos + 1;
+        }
+    }
+}
+
+/*
+ * test_exhaustive - Test a single-argument function on every input
+ * between its minimum and maximum argument values
+ * Returns 0 on success and -1 on failure
+ */
+static int test_exhaustive(puzzle_spec_t *spec, const test_options_t *opts,
+                           test_stats_t *stats) {
+    sweep_t sweep = {
+        .spec = spec,
+        .batch = opts->batch,
+        .reference = opts->reference,
+        .keep_going = opts->max_shown > 0,
+        .max_shown = opts->max_shown,
+        .quiet = opts->json,
+        .num_vals = {1, 1, 1},
+    };
+
+    if (spec->num_args != 1 || puzzle_is_64bit(spec)) {
+        printf("Error: Exhaustive testing is only supported for 32-bit single-argument "
+               "puzzles\n");
+        exit(1);
+    }
+    sweep.first_input = spec->arg_min[0];
+    if (spec->arg_types[0] == INT_ARG) {
+        sweep.num_inputs = (long) spec->arg_max[0] - spec->arg_min[0] + 1;
+    } else {
+        sweep.num_inputs = (unsigned) spec->arg_max[0] - (unsigned) spec->arg_min[0] + 1UL;
+    }
+    int result = run_sweep(&sweep, opts->num_threads, exhaustive_worker);
+    sweep_stats(&sweep, sweep.num_inputs, stats);
+    return result;
+}
+
+/*
+ * input_arg_value - Return the value of command-line argument arg as
+ * argument i of spec. Floating point literals become a float or a
+ * double bit pattern, and integers must fit the argument's width
+ */
+static unsigned long input_arg_value(const puzzle_spec_t *spec, int i, const input_arg_t *arg) {
+    enum argType type = spec->arg_types[i];
+    if (arg->is_float) {
+        return arg_is_64bit(type) ? arg->val : arg->float_val;
+    }
+    if (arg_is_64bit(type)) {
+        return arg->val;
+    }
+    long upperbits = (long) arg->val >> 31;
+    /* will give -1 for negative, 0 or 1 for positive */
+    if (upperbits != 0 && upperbits != -1 && upperbits != 1) {
+        printf("Error: Function argument %d of '%s' must fit in 32 bits\n", i + 1, spec->name);
+        exit(1);
+    }
+    return (unsigned) arg->val;
+}
+
+/*
+ * init_arg_gens - Set up generators for the test values of each
+ * argument of a function. Arguments given on the command line and
+ * unused arguments get a generator for that single value
+ */
+static void init_arg_gens(puzzle_spec_t *spec, input_arg_t *input_args[3], unsigned long seed,
+                          val_gen_t gens[3]) {
+    unsigned test_range;
+    /* Assign range of argument test vals so as to conserve the total
+       number of tests, independent of number of arguments */
+    switch (spec->num_args) {
+        case 0:
+        case 1:
+            test_range = TEST_RANGE;
+            break;
+        case 2:
+            test_range = pow((double) TEST_RANGE, 0.5); /* sqrt */
+            break;
+        case 3:
+            test_range = pow((double) TEST_RANGE, 0.333); /* cbrt */
+            break;
+        default:
+            printf("Error: Invalid number of arguments for test case '%s'\n", spec->name);
+            exit(1);
+    }
+
+    for (int i = spec->num_args; i < 3; i++) {
+        val_gen_init_fixed(&gens[i], 0);
+    }
+    for (int i = 0; i < spec->num_args; i++) {
+        const float_format_t *float_input;
+        switch (spec->arg_types[i]) {
+            case INT_ARG:
+            case UNSIGNED_ARG:
+            case LONG_ARG:
+                float_input = NULL;
+                break;
+            case FLOAT_AS_UNSIGNED_ARG:
+                float_input = &float_format;
+                break;
+            case DOUBLE_AS_ULONG_ARG:
+                float_input = &double_format;
+                break;
+            default:
+                printf("Error: Unknown type for argument %d of test case '%s'\n", i + 1,
+                       spec->name);
+                exit(1);
+        }
+        if (input_args[i] != NULL) {
+            val_gen_init_fixed(&gens[i], input_arg_value(spec, i, input_args[i]));
+        } else {
+            val_gen_init(&gens[i], spec->arg_min[i], spec->arg_max[i], float_input, test_range,
+                         seed, i);
+        }
+    }
+}
+
+/*
+ * Test a specific function.
+ * Returns 0 on success and -1 on failure
+ */
+static int test_function(puzzle_spec_t *spec, input_arg_t *input_args[3],
+                         const test_options_t *opts, test_stats_t *stats) {
+    sweep_t sweep = {
+        .spec = spec,
+        .batch = opts->batch,
+        .reference = opts->reference,
+        .keep_going = opts->max_shown > 0,
+        .max_shown = opts->max_shown,
+        .quiet = opts->json,
+        .check_range = find_range_checker(spec, opts->abi_check),
+        .sentinel_key = random_bits(opts->seed, 3),    // The arguments use streams 0-2
+        .num_vals = {1, 1, 1},
+    };
+    val_gen_t gens[3];
+    init_arg_gens(spec, input_args, opts->seed, gens);
+    sweep.outer_gen = gens[0];
+    for (int i = 1; i < 3; i++) {
+        sweep.vals[i] = val_gen_all(&gens[i], &sweep.num_vals[i], &sweep.regions[i]);
+    }
+
+    int result = run_sweep(&sweep, opts->num_threads, sweep_worker);
+    sweep_stats(&sweep, val_gen_count(&sweep.outer_gen) * sweep.num_vals[1] * sweep.num_vals[2],
+                stats);
+    bool has_random = false;
+    for (int i = 0; i < 3; i++) {
+        has_random |= gens[i].kind == GEN_SAMPLE;
+    }
+    if (result != 0 && has_random && !sweep.quiet) {
+        if (sweep.keep_going) {
+            printf("...Random test values were drawn with --seed %lu\n", opts->seed);
+        } else {
+            printf("...Found at test %lu of the sweep with --seed %lu\n", sweep.fail.pos,
+                   opts->seed);
+        }
+    }
+    for (int i = 1; i < 3; i++) {
+        free(sweep.vals[i]);
+        free(sweep.regions[i]);
+    }
+    return result;
+}
+
+/*
+ * print_json_value - Print a test value or result as a JSON number
+ */
+static void print_json_value(unsigned long val, bool is_signed, bool is_64bit) {
+    if (is_64bit && is_signed) {
+        printf("%ld", (long) val);
+    } else if (is_64bit) {
+        printf("%lu", val);
+    } else if (is_signed) {
+        printf("%d", (int) val);
+    } else {
+        printf("%u", (unsigned) val);
+    }
+}
+
+/*
+ * print_json_result - Print the outcome of testing spec as one line of
+ * JSON. Arguments and results are printed as plain numbers, signed or
+ * unsigned according to their type, so floats appear as bit patterns
+ */
+static void print_json_result(const puzzle_spec_t *spec, const test_stats_t *stats,
+                              double elapsed_sec) {
+    bool signed_ret = ret_is_signed(spec->return_type);
+    bool wide_ret = ret_is_64bit(spec->return_type);
+    printf("{\"puzzle\": \"%s\", \"result\": \"%s\", \"tests\": %lu, \"failures\": %lu",
+           spec->name, stats->num_failed > 0 ? "fail" : "pass", stats->num_tests,
+           stats->num_failed);
+    printf(", \"elapsed_sec\": %.6f, \"tests_per_sec\": %.0f", elapsed_sec,
+           elapsed_sec > 0 ? stats->num_tests / elapsed_sec : 0.0);
+    if (stats->num_failed > 0) {
+        const mismatch_t *fail = &stats->first_fail;
+        printf(", \"first_failure\": {\"args\": [");
+        for (int i = 0; i < spec->num_args; i++) {
+            if (i > 0) {
+                printf(", ");
+            }
+            print_json_value(fail->args[i], arg_is_signed(spec->arg_types[i]),
+                             arg_is_64bit(spec->arg_types[i]));
+        }
+        printf("], \"actual\": ");
+        print_json_value(fail->actual, signed_ret, wide_ret);
+        printf(", \"expected\": ");
+        print_json_value(fail->expected, signed_ret, wide_ret);
+        if (fail->abi_errors != 0) {
+            printf(", \"abi_violations\": [");
+            const char *sep = "";
+            for (int i = 0; i < NUM_ABI_VIOLATIONS; i++) {
+                if (fail->abi_errors & (1u << i)) {
+                    printf("%s\"%s\"", sep, abi_violation_names[i]);
+                    sep = ", ";
+                }
+            }
+            printf("]");
+        }
+        printf("}");
+    }
+    printf("}\n");
+    fflush(stdout);
+}
+
+/*
+ * run_puzzle - Test one puzzle, exhaustively or by sampling, and report
+ * the outcome in the format chosen on the command line
+ * Returns 0 on success and -1 on failure
+ */
+static int run_puzzle(puzzle_spec_t *spec, input_arg_t *input_args[3],
+                      const test_options_t *opts) {
+    test_stats_t stats = {0};
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int result;
+    if (opts->exhaustive) {
+        result = test_exhaustive(spec, opts, &stats);
+    } else {
+        result = test_function(spec, input_args, opts, &stats);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (opts->json) {
+        double elapsed_sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        print_json_result(spec, &stats, elapsed_sec);
+    }
+    return result;
+}
+
+/*
+ * library_symbol - Look up a function exported by the --library
+ * libbits.so, with the symbol version the current libbits.h declares
+ */
+static int (*library_symbol(const test_options_t *opts, const char *name))(void) {
+    void *sym = dlvsym(opts->library_handle, name, LIBBITS_VERSION_NODE);
+    if (sym == NULL) {
+        printf("Error: %s does not export %s@%s\n", opts->library, name, LIBBITS_VERSION_NODE);
+        exit(1);
+    }
+    return (int (*)(void)) sym;
+}
+
+/*
+ * library_reduction - Return r with its kernels replaced by the ones
+ * the --library libbits.so exports, or r itself without --library
+ */
+static reduction_t library_reduction(const reduction_t *r, const test_options_t *opts) {
+    reduction_t lib_r = *r;
+    if (opts->library_handle == NULL) {
+        return lib_r;
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "count_%s", r->puzzle);
+    lib_r.count = (size_t (*)(const int *, size_t)) library_symbol(opts, name);
+    snprintf(name, sizeof(name), "any_%s", r->puzzle);
+    lib_r.any = (int (*)(const int *, size_t)) library_symbol(opts, name);
+    snprintf(name, sizeof(name), "all_%s", r->puzzle);
+    lib_r.all = (int (*)(const int *, size_t)) library_symbol(opts, name);
+    return lib_r;
+}
+
+/* Names of the ISA_* extensions, by bit number */
+static const char *isa_names[] = {"BMI1", "BMI2", "POPCNT", "AVX512F"};
+
+/*
+ * puzzle_variants - Store the implementations of spec to test or time
+ * in variants: spec itself, then with --variants a copy of spec for
+ * each of its kernel variants the CPU supports and for its NAME_auto
+ * entry point, named after that function and with it as impl_func, or
+ * as batch_func for the batched variants with --batch.
+ * Variants the CPU can't run are skipped with a note, unless the
+ * output is JSON or the puzzles were picked with --all, so that a run
+ * over many puzzles stays silent when they pass. With --library,
+ * every function is the one of the same name the library exports
+ * Returns the number of specs stored
+ */
+static int puzzle_variants(const puzzle_spec_t *spec, const test_options_t *opts,
+                           puzzle_spec_t variants[MAX_VARIANTS]) {
+    int count = 0;
+    variants[count++] = *spec;
+    if (opts->library_handle != NULL) {
+        variants[0].impl_func = library_symbol(opts, spec->name);
+        if (spec->batch_func != NULL) {
+            char name[64];
+            snprintf(name, sizeof(name), "%s_n", spec->name);
+            variants[0].batch_func = library_symbol(opts, name);
+        }
+    }
+    if (!opts->variants) {
+        return count;
+    }
+
+    unsigned isa = cpu_isa();
+    const kernel_variant_t *tables[] = {kernel_variants, dispatched_kernels};
+    for (int t = 0; t < 2; t++) {
+        for (const kernel_variant_t *variant = tables[t]; variant->puzzle != NULL; variant++) {
+            if (strcmp(variant->puzzle, spec->name) != 0 || variant->batch != opts->batch) {
+                continue;
+            }
+            unsigned missing = variant->isa & ~isa;
+            if (missing != 0) {
+                if (!opts->json && !opts->all) {
+                    printf("Skipping %s, the CPU lacks", variant->name);
+                    for (size_t i = 0; i < sizeof(isa_names) / sizeof(isa_names[0]); i++) {
+                        if (missing & (1u << i)) {
+                            printf(" %s", isa_names[i]);
+                        }
+                    }
+                    printf("\n");
+                }
+                continue;
+            }
+            if (count == MAX_VARIANTS) {
+                printf("Error: Puzzle '%s' has more than %d variants\n", spec->name,
+                       MAX_VARIANTS);
+                exit(1);
+            }
+            variants[count] = *spec;
+            variants[count].name = (char *) variant->name;
+            int (*func)(void) = variant->func;
+            if (opts->library_handle != NULL) {
+                func = library_symbol(opts, variant->name);
+            }
+            if (variant->batch) {
+                variants[count].batch_func = func;
+            } else {
+                variants[count].impl_func = func;
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+/*
+ * read_cycles_start - Read the time stamp counter at the start of a
+ * timed region. The fences keep earlier instructions from finishing
+ * inside the region and later ones from starting before the read
+ */
+static inline unsigned long read_cycles_start(void) {
+    _mm_lfence();
+    unsigned long cycles = __rdtsc();
+    _mm_lfence();
+    return cycles;
+}
+
+/*
+ * read_cycles_end - Read the time stamp counter at the end of a timed
+ * region. rdtscp waits for the region's instructions to complete, and
+ * the fence keeps later instructions from starting before the read
+ */
+static inline unsigned long read_cycles_end(void) {
+    unsigned aux;
+    unsigned long cycles = __rdtscp(&aux);
+    _mm_lfence();
+    return cycles;
+}
+
+/*
+ * compare_doubles - qsort() comparison function for doubles
+ */
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/* Cycle counts for one function, per call */
+typedef struct {
+    double median;
+    double p99;
+} bench_result_t;
+
+/*
+ * bench_func - Time func (the puzzle's impl_func or test_func, or
+ * batch_func if is_batch is set) on blocks of BENCH_BLOCK inputs
+ * Each sample is one timed block, less the cost of an empty timed region
+ */
+static bench_result_t bench_func(puzzle_spec_t *spec, int (*func)(void), bool is_batch,
+                                 unsigned *args[3], unsigned overhead) {
+    static double samples[BENCH_REPS * (BENCH_INPUTS / BENCH_BLOCK)];
+    unsigned out[BENCH_BLOCK];
+    unsigned num_samples = 0;
+
+    for (int rep = -BENCH_WARMUP_REPS; rep < BENCH_REPS; rep++) {
+        for (unsigned begin = 0; begin < BENCH_INPUTS; begin += BENCH_BLOCK) {
+            unsigned *block_args[3] = {args[0] + begin, args[1] + begin, args[2] + begin};
+            unsigned long start = read_cycles_start();
+            if (is_batch) {
+                call_batch(spec, block_args, out, BENCH_BLOCK);
+            } else {
+                eval_func(spec, func, block_args, out, BENCH_BLOCK);
+            }
+            unsigned long cycles = read_cycles_end() - start;
+            if (rep >= 0) {
+                cycles = cycles > overhead ? cycles - overhead : 0;
+                samples[num_samples++] = (double) cycles / BENCH_BLOCK;
+            }
+        }
+    }
+
+    qsort(samples, num_samples, sizeof(samples[0]), compare_doubles);
+    bench_result_t result = {
+        .median = samples[num_samples / 2],
+        .p99 = samples[num_samples * 99 / 100],
+    };
+    return result;
+}
+
+/*
+ * timer_overhead - Return the median number of cycles measured for an
+ * empty timed region
+ */
+static unsigned timer_overhead(void) {
+    static double samples[BENCH_REPS];
+    for (int i = 0; i < BENCH_REPS; i++) {
+        unsigned long start = read_cycles_start();
+        samples[i] = read_cycles_end() - start;
+    }
+    qsort(samples, BENCH_REPS, sizeof(samples[0]), compare_doubles);
+    return samples[BENCH_REPS / 2];
+}
+
+/*
+ * sample_bench_inputs - Fill args[0..2] with BENCH_INPUTS combinations
+ * of arguments, sampled from the same test values test_function uses.
+ * If classes is not NULL, it is filled with the class of each
+ * combination: a number identifying the regions its arguments came from
+ */
+static void sample_bench_inputs(puzzle_spec_t *spec, input_arg_t *input_args[3],
+                                const test_options_t *opts, unsigned *args[3],
+                                unsigned classes[]) {
+    long *vals[3];
+    unsigned char *regions[3];
+    unsigned num_vals[3];
+    long outer_vals[SWEEP_MAX_CHUNK_VALS];
+    unsigned char outer_regions[SWEEP_MAX_CHUNK_VALS];
+
+    /* Spread the benchmark inputs evenly over the positions of a sweep
+       so that every region the generators cover is represented. The
+       first argument's values are streamed just like in a sweep */
+    val_gen_t gens[3];
+    init_arg_gens(spec, input_args, opts->seed, gens);
+    for (int i = 1; i < 3; i++) {
+        vals[i] = val_gen_all(&gens[i], &num_vals[i], &regions[i]);
+    }
+    unsigned long inner_tests = num_vals[1] * num_vals[2];
+    unsigned long num_tests = val_gen_count(&gens[0]) * inner_tests;
+    unsigned next = 0;
+    unsigned long first_outer = 0;
+    unsigned n;
+    while (next < BENCH_INPUTS &&
+           (n = val_gen_next(&gens[0], outer_vals, outer_regions, SWEEP_MAX_CHUNK_VALS)) > 0) {
+        for (; next < BENCH_INPUTS; next++) {
+            unsigned long pos = next * num_tests / BENCH_INPUTS;
+            if (pos / inner_tests >= first_outer + n) {
+                break;
+            }
+            unsigned i = pos / inner_tests - first_outer;
+            unsigned j = pos % inner_tests / num_vals[2];
+            unsigned k = pos % num_vals[2];
+            args[0][next] = outer_vals[i];
+            args[1][next] = vals[1][j];
+            args[2][next] = vals[2][k];
+            if (classes != NULL) {
+                classes[next] =
+                    (outer_regions[i] * NUM_REGIONS + regions[1][j]) * NUM_REGIONS + regions[2][k];
+            }
+        }
+        first_outer += n;
+    }
+    for (int i = 1; i < 3; i++) {
+        free(vals[i]);
+        free(regions[i]);
+    }
+}
+
+/*
+ * bench_function - Time a specific function and its oracle on a sample
+ * of the same test values test_function uses, and print one line of
+ * the benchmark report
+ */
+static void bench_function(puzzle_spec_t *spec, input_arg_t *input_args[3],
+                           const test_options_t *opts, unsigned overhead) {
+    static unsigned bench_args[3][BENCH_INPUTS];
+    unsigned *args[3] = {bench_args[0], bench_args[1], bench_args[2]};
+    sample_bench_inputs(spec, input_args, opts, args, NULL);
+
+    bench_result_t impl;
+    if (opts->batch) {
+        impl = bench_func(spec, spec->batch_func, true, args, overhead);
+    } else {
+        impl = bench_func(spec, spec->impl_func, false, args, overhead);
+    }
+    bench_result_t oracle = bench_func(spec, spec->test_func, false, args, overhead);
+    printf("%-*s %8.2f %8.2f %10.2f %8.2f %9.2fx\n", NAME_WIDTH, spec->name, impl.median,
+           impl.p99, oracle.median, oracle.p99,
+           oracle.median > 0 ? impl.median / oracle.median : 0);
+}
+
+/*
+ * print_bench_header - Print the column headings of the benchmark report
+ */
+static void print_bench_header(const test_options_t *opts) {
+    printf("Time stamp counter cycles per call (%u calls per sample, %u samples per function)\n",
+           BENCH_BLOCK, BENCH_REPS * (BENCH_INPUTS / BENCH_BLOCK));
+    printf("%-*s %17s %19s %10s\n", NAME_WIDTH, "", opts->batch ? "batch_func" : "impl_func",
+           "test_func", "impl/test");
+    printf("%-*s %8s %8s %10s %8s %10s\n", NAME_WIDTH, "Puzzle", "median", "p99", "median", "p99",
+           "median");
+}
+
+/* Hardware events counted by --perf */
+enum perf_counter {
+    PERF_CYCLES,    // The group leader, which the others are only counted with
+    PERF_INSTRUCTIONS,
+    PERF_BRANCHES,
+    PERF_BRANCH_MISSES,
+    PERF_L1D_MISSES,
+    NUM_PERF_COUNTERS,
+};
+
+static const struct {
+    unsigned type;
+    unsigned long config;
+} perf_events[NUM_PERF_COUNTERS] = {
+    [PERF_CYCLES] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    [PERF_INSTRUCTIONS] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    [PERF_BRANCHES] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+    [PERF_BRANCH_MISSES] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    [PERF_L1D_MISSES] = {PERF_TYPE_HW_CACHE,
+                         PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                             PERF_COUNT_HW_CACHE_RESULT_MISS << 16},
+};
+
+/*
+ * perf_open - Open a group of counters for the events in perf_events,
+ * counting user-space events of the calling thread. fds[i] is set to -1
+ * for events the CPU or kernel cannot count
+ * Returns false, with errno set, if not even the cycle counter opened
+ */
+static bool perf_open(int fds[NUM_PERF_COUNTERS]) {
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        struct perf_event_attr attr = {
+            .size = sizeof(attr),
+            .type = perf_events[i].type,
+            .config = perf_events[i].config,
+            .disabled = i == PERF_CYCLES,
+            .exclude_kernel = 1,
+            .exclude_hv = 1,
+            .read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING,
+        };
+        int group_fd = i == PERF_CYCLES ? -1 : fds[PERF_CYCLES];
+        fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+        if (i == PERF_CYCLES && fds[i] < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * perf_read - Read a counter, scaled up for any time the kernel had to
+ * take it off the PMU to share it. Returns -1 if the event was never
+ * counted
+ */
+static double perf_read(int fd) {
+    unsigned long values[3];    // Count, time enabled, time running
+    if (fd < 0 || read(fd, values, sizeof(values)) != sizeof(values) || values[2] == 0) {
+        return -1;
+    }
+    return (double) values[0] * values[1] / values[2];
+}
+
+/*
+ * print_perf_value - Print one column of the --perf report, or a dash
+ * if its events could not be counted
+ */
+static void print_perf_value(double value, int width, int precision) {
+    if (value < 0) {
+        printf(" %*s", width, "-");
+    } else {
+        printf(" %*.*f", width, precision, value);
+    }
+}
+
+/*
+ * perf_function - Count hardware events while a specific function runs
+ * over a sample of the same test values test_function uses, and print
+ * one line of the --perf report. perf_fds are the counters from
+ * perf_open(), or all -1 if they are unavailable, in which case only the
+ * time stamp counter is read
+ */
+static void perf_function(puzzle_spec_t *spec, input_arg_t *input_args[3],
+                          const test_options_t *opts, const int perf_fds[NUM_PERF_COUNTERS]) {
+    static unsigned bench_args[3][BENCH_INPUTS];
+    static unsigned out[BENCH_INPUTS];
+    unsigned *args[3] = {bench_args[0], bench_args[1], bench_args[2]};
+    int leader = perf_fds[PERF_CYCLES];
+    sample_bench_inputs(spec, input_args, opts, args, NULL);
+
+    unsigned long start = 0;
+    for (int rep = -BENCH_WARMUP_REPS; rep < BENCH_REPS; rep++) {
+        if (rep == 0) {
+            if (leader >= 0) {
+                ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+            start = read_cycles_start();
+        }
+        if (opts->batch) {
+            call_batch(spec, args, out, BENCH_INPUTS);
+        } else {
+            eval_func(spec, spec->impl_func, args, out, BENCH_INPUTS);
+        }
+    }
+    unsigned long tsc = read_cycles_end() - start;
+    if (leader >= 0) {
+        ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    double calls = (double) BENCH_REPS * BENCH_INPUTS;
+    double per_call[NUM_PERF_COUNTERS];
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        double count = perf_read(perf_fds[i]);
+        per_call[i] = count < 0 ? -1 : count / calls;
+    }
+    double cycles = per_call[PERF_CYCLES];
+    double instructions = per_call[PERF_INSTRUCTIONS];
+    double branches = per_call[PERF_BRANCHES];
+    double misses = per_call[PERF_BRANCH_MISSES];
+    double l1d_misses = per_call[PERF_L1D_MISSES];
+
+    printf("%-*s", NAME_WIDTH, spec->name);
+    print_perf_value(tsc / calls, 8, 2);
+    print_perf_value(cycles, 8, 2);
+    print_perf_value(instructions, 8, 2);
+    print_perf_value(cycles > 0 && instructions >= 0 ? instructions / cycles : -1, 6, 2);
+    print_perf_value(branches, 9, 2);
+    print_perf_value(branches > 0 && misses >= 0 ? 100 * misses / branches : -1, 7, 2);
+    print_perf_value(l1d_misses < 0 ? -1 : 1000 * l1d_misses, 10, 2);
+    printf("\n");
+}
+
+/*
+ * print_perf_header - Print the column headings of the --perf report
+ */
+static void print_perf_header(const test_options_t *opts) {
+    printf("Events per call of %s (%u inputs, %u passes, including btest's calling loop)\n",
+           opts->batch ? "batch_func" : "impl_func", BENCH_INPUTS, BENCH_REPS);
+    printf("%-*s %8s %8s %8s %6s %9s %7s %10s\n", NAME_WIDTH, "Puzzle", "TSC", "cycles", "instr",
+           "IPC", "branches", "miss%", "L1D/1000");
+}
+
+/* Orders --bench-orders times each puzzle's inputs in */
+enum bench_order {
+    ORDER_SWEEP,          // As sampled, following the sweep's interleaving of regions
+    ORDER_SORTED,         // By argument values, compared as unsigned integers
+    ORDER_SHUFFLED,       // Uniformly random
+    ORDER_ALTERNATING,    // Round-robin over the input classes
+    ORDER_ADVERSARIAL,    // A random class at every step, whatever the class sizes
+    NUM_BENCH_ORDERS,
+};
+
+static const char *bench_order_names[NUM_BENCH_ORDERS] = {
+    [ORDER_SWEEP] = "sweep",
+    [ORDER_SORTED] = "sorted",
+    [ORDER_SHUFFLED] = "shuffled",
+    [ORDER_ALTERNATING] = "alternating",
+    [ORDER_ADVERSARIAL] = "adversarial",
+};
+
+/* Number of distinct input classes from sample_bench_inputs() */
+#define NUM_INPUT_CLASSES (NUM_REGIONS * NUM_REGIONS * NUM_REGIONS)
+
+/* One benchmark input, with its class from sample_bench_inputs() */
+typedef struct {
+    unsigned args[3];
+    unsigned cls;
+} bench_input_t;
+
+/*
+ * compare_bench_inputs - qsort() comparison function that orders inputs
+ * by their arguments, as unsigned integers
+ */
+static int compare_bench_inputs(const void *a, const void *b) {
+    const unsigned *x = ((const bench_input_t *) a)->args;
+    const unsigned *y = ((const bench_input_t *) b)->args;
+    for (int i = 0; i < 3; i++) {
+        if (x[i] != y[i]) {
+            return x[i] < y[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * order_bench_inputs - Rearrange n inputs, given in sweep order, into
+ * another order. key selects the random stream for the random orders
+ *
+ * The class-based orders keep the inputs of each class in sweep order.
+ * Alternating takes one input from each class in turn, which is easy to
+ * predict if a kernel's branches follow its classes. Adversarial picks
+ * the class of each next input at random, with every class that has
+ * inputs left equally likely. Unlike shuffling, this doesn't let a large
+ * class make the common case predictable
+ */
+static void order_bench_inputs(bench_input_t inputs[], unsigned n, enum bench_order order,
+                               unsigned long key) {
+    static bench_input_t grouped[BENCH_INPUTS];
+    static unsigned class_next[NUM_INPUT_CLASSES];
+    static unsigned class_end[NUM_INPUT_CLASSES];
+    unsigned active[NUM_INPUT_CLASSES];
+    unsigned num_active = 0;
+
+    switch (order) {
+        case ORDER_SWEEP:
+        case NUM_BENCH_ORDERS:
+            return;
+
+        case ORDER_SORTED:
+            qsort(inputs, n, sizeof(inputs[0]), compare_bench_inputs);
+            return;
+
+        case ORDER_SHUFFLED:
+            for (unsigned i = n - 1; i > 0; i--) {
+                unsigned j = random_bits(key, i) % (i + 1);
+                bench_input_t tmp = inputs[i];
+                inputs[i] = inputs[j];
+                inputs[j] = tmp;
+            }
+            return;
+
+        case ORDER_ALTERNATING:
+        case ORDER_ADVERSARIAL:
+            break;
+    }
+
+    /* Group the inputs by class with a counting sort, which keeps each
+       class in sweep order */
+    memset(class_end, 0, sizeof(class_end));
+    for (unsigned i = 0; i < n; i++) {
+        class_end[inputs[i].cls]++;
+    }
+    unsigned begin = 0;
+    for (unsigned c = 0; c < NUM_INPUT_CLASSES; c++) {
+        if (class_end[c] > 0) {
+            active[num_active++] = c;
+        }
+        class_next[c] = begin;
+        begin += class_end[c];
+        class_end[c] = class_next[c];
+    }
+    for (unsigned i = 0; i < n; i++) {
+        grouped[class_end[inputs[i].cls]++] = inputs[i];
+    }
+
+    unsigned out = 0;
+    if (order == ORDER_ALTERNATING) {
+        while (num_active > 0) {
+            unsigned still_active = 0;
+            for (unsigned a = 0; a < num_active; a++) {
+                unsigned c = active[a];
+                inputs[out++] = grouped[class_next[c]++];
+                if (class_next[c] < class_end[c]) {
+                    active[still_active++] = c;
+                }
+            }
+            num_active = still_active;
+        }
+    } else {
+        while (num_active > 0) {
+            unsigned a = random_bits(key, out) % num_active;
+            unsigned c = active[a];
+            inputs[out++] = grouped[class_next[c]++];
+            if (class_next[c] == class_end[c]) {
+                active[a] = active[--num_active];
+            }
+        }
     }
+}
 
-    /*
-     * Normal case: Generate test vals for integer functions
-     */
+/*
+ * bench_orders_function - Time a specific function on a sample of the
+ * same test values test_function uses, arranged in each of the orders
+ * in enum bench_order, and print one line of the --bench-orders report
+ */
+static void bench_orders_function(puzzle_spec_t *spec, input_arg_t *input_args[3],
+                                  const test_options_t *opts, unsigned overhead) {
+    static unsigned bench_args[3][BENCH_INPUTS];
+    static unsigned ordered_args[3][BENCH_INPUTS];
+    static unsigned classes[BENCH_INPUTS];
+    static bench_input_t inputs[BENCH_INPUTS];
+    unsigned *args[3] = {bench_args[0], bench_args[1], bench_args[2]};
+    unsigned *ordered[3] = {ordered_args[0], ordered_args[1], ordered_args[2]};
+    sample_bench_inputs(spec, input_args, opts, args, classes);
+
+    double fastest = 0;
+    double slowest = 0;
+    printf("%-*s", NAME_WIDTH, spec->name);
+    for (int order = 0; order < NUM_BENCH_ORDERS; order++) {
+        for (unsigned i = 0; i < BENCH_INPUTS; i++) {
+            inputs[i] = (bench_input_t) {{args[0][i], args[1][i], args[2][i]}, classes[i]};
+        }
+        // The arguments' random streams are 0-2 and --abi-check's is 3
+        order_bench_inputs(inputs, BENCH_INPUTS, order, random_bits(opts->seed, 4));
+        for (unsigned i = 0; i < BENCH_INPUTS; i++) {
+            for (int a = 0; a < 3; a++) {
+                ordered[a][i] = inputs[i].args[a];
+            }
+        }
 
-    /* If the range is small enough, then do exhaustively */
-    if (max - MAX_TEST_VALS <= min) {
-        for (int i = min; i <= max; i++)
-            test_vals[test_count++] = i;
-        return test_count;
+        bench_result_t result;
+        if (opts->batch) {
+            result = bench_func(spec, spec->batch_func, true, ordered, overhead);
+        } else {
+            result = bench_func(spec, spec->impl_func, false, ordered, overhead);
+        }
+        printf(" %11.2f", result.median);
+        if (order == 0 || result.median < fastest) {
+            fastest = result.median;
+        }
+        if (order == 0 || result.median > slowest) {
+            slowest = result.median;
+        }
     }
+    printf(" %8.2fx\n", fastest > 0 ? slowest / fastest : 0);
+}
 
-    /* Otherwise, need to sample.  Do so near the boundaries, around
-       zero, and for some random cases. */
-    for (int i = 0; i < test_range; i++) {
-        /* Test around the boundaries */
-        test_vals[test_count++] = min + i;
-        test_vals[test_count++] = max - i;
+/*
+ * print_bench_orders_header - Print the column headings of the
+ * --bench-orders report
+ */
+static void print_bench_orders_header(const test_options_t *opts) {
+    printf("Median time stamp counter cycles per call of %s, on the same %u inputs in each "
+           "order\n",
+           opts->batch ? "batch_func" : "impl_func", BENCH_INPUTS);
+    printf("%-*s", NAME_WIDTH, "Puzzle");
+    for (int order = 0; order < NUM_BENCH_ORDERS; order++) {
+        printf(" %11s", bench_order_names[order]);
+    }
+    printf(" %9s\n", "slow/fast");
+}
 
-        /* If zero falls between min and max, then also test around zero */
-        if (i >= min && i <= max) {
-            test_vals[test_count++] = i;
+/*
+ * throughput_function - Time a specific function's batched
+ * implementation on arrays of THROUGHPUT_BYTES, tiled with a sample of
+ * the same test values test_function uses, and print one line of the
+ * --throughput report. Single-argument puzzles write their results over
+ * their inputs, the way a buffer of floats is rescaled in place. Bytes
+ * count both the arrays read and the one written
+ */
+static void throughput_function(puzzle_spec_t *spec, input_arg_t *input_args[3],
+                                const test_options_t *opts) {
+    static unsigned bench_args[3][BENCH_INPUTS];
+    static double samples[THROUGHPUT_REPS];
+    unsigned *args[3] = {bench_args[0], bench_args[1], bench_args[2]};
+    sample_bench_inputs(spec, input_args, opts, args, NULL);
+
+    // The input arrays, then the output array unless it is the input
+    size_t n = THROUGHPUT_BYTES / sizeof(unsigned);
+    unsigned *arrays[4];
+    int num_arrays = spec->num_args == 1 ? 1 : spec->num_args + 1;
+    for (int a = 0; a < num_arrays; a++) {
+        arrays[a] = malloc(THROUGHPUT_BYTES);
+        if (arrays[a] == NULL) {
+            printf("Error: Out of memory\n");
+            exit(1);
         }
-        if (-i >= min && -i <= max) {
-            test_vals[test_count++] = -i;
+        // Writing every element also maps the pages before the timing
+        for (size_t i = 0; i < n; i++) {
+            arrays[a][i] = a < spec->num_args ? args[a][i % BENCH_INPUTS] : 0;
         }
-
-        /* Random case between min and max */
-        test_vals[test_count++] = random_val(min, max);
     }
-    return test_count;
+    unsigned *out = arrays[num_arrays - 1];
+
+    for (int rep = -1; rep < THROUGHPUT_REPS; rep++) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        call_batch(spec, arrays, out, n);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        if (rep >= 0) {
+            samples[rep] = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        }
+    }
+    for (int a = 0; a < num_arrays; a++) {
+        free(arrays[a]);
+    }
+
+    qsort(samples, THROUGHPUT_REPS, sizeof(samples[0]), compare_doubles);
+    double bytes = (double) (spec->num_args + 1) * THROUGHPUT_BYTES;
+    double median = samples[THROUGHPUT_REPS / 2];
+    printf("%-*s %10.2f %10.2f %12.3f\n", NAME_WIDTH, spec->name, bytes / median / 1e9,
+           bytes / samples[0] / 1e9, n / median / 1e9);
 }
 
 /*
- * Test a specific function.
- * Returns 0 on success and -1 on failure
+ * print_throughput_header - Print the column headings of the
+ * --throughput report
  */
-static int test_function(puzzle_spec_t *spec, unsigned *input_args[3]) {
-    /* These are the test values for each arg. Declared with the
-       static attribute so that the array will be allocated in bss
-       rather than the stack */
-    static int arg_test_vals[3][MAX_TEST_VALS];
-    unsigned num_args[3];
+static void print_throughput_header(void) {
+    printf("batch_func streaming through %lu MiB arrays (median and best of %d passes)\n",
+           THROUGHPUT_BYTES >> 20, THROUGHPUT_REPS);
+    printf("%-*s %10s %10s %12s\n", NAME_WIDTH, "Puzzle", "GB/s", "best GB/s", "Gelements/s");
+}
 
-    unsigned test_range;
-    /* Assign range of argument test vals so as to conserve the total
-       number of tests, independent of number of arguments */
-    switch (spec->num_args) {
-        case 0:
-        case 1:
-            test_range = TEST_RANGE;
-            break;
-        case 2:
-            test_range = pow((double) TEST_RANGE, 0.5); /* sqrt */
-            break;
-        case 3:
-            test_range = pow((double) TEST_RANGE, 0.333); /* cbrt */
-            break;
-        default:
-            printf("Error: Invalid number of arguments for test case '%s'\n", spec->name);
-            exit(1);
+/*
+ * reduce_check - Compare op over the n words at x, computed by the
+ * kernels of r split across num_threads threads, with the answer of r's
+ * oracle, and print the failure if they differ
+ * Returns 0 on success and -1 on failure
+ */
+static int reduce_check(const reduction_t *r, reduce_op_t op, const int x[], size_t n,
+                        unsigned num_threads) {
+    size_t actual = reduce_words(r, op, x, n, num_threads);
+    size_t expected = reduce_oracle(r, op, x, n);
+    if (actual == expected) {
+        return 0;
     }
+    printf("ERROR: Test %s_%s on %zu words failed...\n", reduce_op_names[op], r->puzzle, n);
+    printf("...Gives %zu. Should be %zu\n", actual, expected);
+    return -1;
+}
 
-    for (int i = 0; i < spec->num_args; i++) {
-        bool is_float_input;
-        switch (spec->arg_types[i]) {
-            case INT_ARG:
-            case UNSIGNED_ARG:
-                is_float_input = false;
-                break;
-            case FLOAT_AS_UNSIGNED_ARG:
-                is_float_input = true;
-                break;
-            default:
-                printf("Error: Unknown type for argument %d of test case '%s'\n", i + 1,
-                       spec->name);
-                exit(1);
-        }
-        if (input_args[i] != NULL) {
-            num_args[i] = 1;
-            unsigned *arg_ptr = input_args[i];
-            arg_test_vals[i][0] = *arg_ptr;
-        } else {
-            num_args[i] = gen_vals(arg_test_vals[i], spec->arg_min[i], spec->arg_max[i],
-                                   is_float_input, test_range);
+/*
+ * test_reductions - Test the count_, any_ and all_ reductions of a
+ * predicate puzzle against its oracle, on a sample of the same test
+ * values test_function uses:
+ *   - every prefix of the sample up to REDUCE_MAX_SHORT words, which
+ *     covers every length of the kernels' tail loops, and all of it
+ *   - short arrays of one value the puzzle is true for with a single
+ *     false one at each position, and the other way round, so that any_
+ *     and all_ are caught stopping at the wrong word
+ *   - the sample tiled over an array long enough to be split across
+ *     threads, also with a single deciding value at its end
+ * Returns 0 on success and -1 on failure
+ */
+static int test_reductions(puzzle_spec_t *spec, const reduction_t *r, input_arg_t *input_args[3],
+                           const test_options_t *opts) {
+    static unsigned bench_args[3][BENCH_INPUTS];
+    unsigned *args[3] = {bench_args[0], bench_args[1], bench_args[2]};
+    sample_bench_inputs(spec, input_args, opts, args, NULL);
+    const int *sample = (const int *) args[0];
+
+    for (size_t n = 0; n <= REDUCE_MAX_SHORT + 1; n++) {
+        size_t len = n <= REDUCE_MAX_SHORT ? n : BENCH_INPUTS;
+        for (int op = 0; op < NUM_REDUCE_OPS; op++) {
+            if (reduce_check(r, op, sample, len, 1) != 0) {
+                return -1;
+            }
         }
     }
 
-    switch (spec->num_args) {
-        case 0:
-            switch (spec->return_type) {
-                case INT_RET: {
-                    int (*impl)(void) = spec->impl_func;
-                    int (*test)(void) = spec->test_func;
-                    int actual = impl();
-                    int expected = test();
-                    if (actual != expected) {
-                        printf(
-                            "ERROR: Test %s() failed...\n...Gives %d[0x%x]. Should be %d[0x%x]\n",
-                            spec->name, actual, actual, expected, expected);
-                        return -1;
-                    }
-                    return 0;
-                }
+    // A value the puzzle is true for and one it is false for, if the
+    // sample has both
+    int values[2];
+    bool found[2] = {false, false};
+    for (unsigned i = 0; i < BENCH_INPUTS; i++) {
+        int truth = r->oracle(sample[i]) != 0;
+        values[truth] = sample[i];
+        found[truth] = true;
+    }
 
-                case UNSIGNED_RET: {
-                    unsigned (*impl)(void) = (unsigned (*)(void)) spec->impl_func;
-                    unsigned (*test)(void) = (unsigned (*)(void)) spec->test_func;
-                    unsigned actual = impl();
-                    unsigned expected = test();
-                    if (actual != expected) {
-                        printf(
-                            "ERROR: Test %s() failed...\n...Gives %d[0x%x]. Should be %d[0x%x]\n",
-                            spec->name, actual, actual, expected, expected);
+    int short_array[REDUCE_MAX_SHORT];
+    for (int fill = 0; fill < 2 && found[0] && found[1]; fill++) {
+        for (size_t n = 1; n <= REDUCE_MAX_SHORT; n++) {
+            for (size_t pos = 0; pos < n; pos++) {
+                for (size_t i = 0; i < n; i++) {
+                    short_array[i] = values[i == pos ? !fill : fill];
+                }
+                for (int op = 0; op < NUM_REDUCE_OPS; op++) {
+                    if (reduce_check(r, op, short_array, n, 1) != 0) {
                         return -1;
                     }
-                    return 0;
                 }
-
-                default:
-                    printf("Unkonwn return type for test '%s'\n", spec->name);
-                    exit(1);
-            }
-
-        case 1:
-            switch (spec->return_type) {
-                case INT_RET:
-                    switch (spec->arg_types[0]) {
-                        case INT_ARG: {
-                            int (*impl)(int) = (int (*)(int)) spec->impl_func;
-                            int (*test)(int) = (int (*)(int)) spec->test_func;
-                            for (int i = 0; i < num_args[0]; i++) {
-                                int arg1 = arg_test_vals[0][i];
-                                int actual = impl(arg1);
-                                int expected = test(arg1);
-                                if (actual != expected) {
-                                    printf(
-                                        "ERROR: Test %s(%d[0x%x]) failed...\n...Gives %d[0x%x]. "
-                                        "Should be %d[0x%x]\n",
-                                        spec->name, arg1, arg1, actual, actual, expected, expected);
-                                    return -1;
-                                }
-                            }
-                            return 0;
-                        }
-
-                        case FLOAT_AS_UNSIGNED_ARG:
-                        case UNSIGNED_ARG: {
-                            int (*impl)(unsigned) = (int (*)(unsigned)) spec->impl_func;
-                            int (*test)(unsigned) = (int (*)(unsigned)) spec->test_func;
-                            for (int i = 0; i < num_args[0]; i++) {
-                                unsigned arg1 = arg_test_vals[0][i];
-                                int actual = impl(arg1);
-                                int expected = test(arg1);
-                                if (actual != expected) {
-                                    printf(
-                                        "ERROR: Test %s(%d[0x%x]) failed...\n...Gives %d[0x%x]. "
-                                        "Should be %d[0x%x]\n",
-                                        spec->name, arg1, arg1, actual, actual, expected, expected);
-                                    return -1;
-                                }
-                            }
-                            return 0;
-                        }
-
-                        default:
-                            printf("Unknown type for argument 1 of test '%s'\n", spec->name);
-                            exit(1);
-                    }
-
-                case UNSIGNED_RET:
-                    switch (spec->arg_types[0]) {
-                        case INT_ARG: {
-                            unsigned (*impl)(int) = (unsigned (*)(int)) spec->impl_func;
-                            unsigned (*test)(int) = (unsigned (*)(int)) spec->test_func;
-                            for (int i = 0; i < num_args[0]; i++) {
-                                int arg1 = arg_test_vals[0][i];
-                                unsigned actual = impl(arg1);
-                                unsigned expected = test(arg1);
-                                if (actual != expected) {
-                                    printf(
-                                        "ERROR: Test %s(%u[0x%x]) failed...\n...Gives %u[0x%x]. "
-                                        "Should be %u[0x%x]\n",
-                                        spec->name, arg1, arg1, actual, actual, expected, expected);
-                                    return -1;
-                                }
-                            }
-                            return 0;
-                        }
-
-                        case FLOAT_AS_UNSIGNED_ARG:
-                        case UNSIGNED_ARG: {
-                            unsigned (*impl)(unsigned) = (unsigned (*)(unsigned)) spec->impl_func;
-                            unsigned (*test)(unsigned) = (unsigned (*)(unsigned)) spec->test_func;
-                            for (int i = 0; i < num_args[0]; i++) {
-                                unsigned arg1 = arg_test_vals[0][i];
-                                unsigned actual = impl(arg1);
-                                unsigned expected = test(arg1);
-                                if (actual != expected) {
-                                    printf(
-                                        "ERROR: Test %s(%u[0x%x]) failed...\n...Gives %u[0x%x]. "
-                                        "Should be %u[0x%x]\n",
-                                        spec->name, arg1, arg1, actual, actual, expected, expected);
-                                    return -1;
-                                }
-                            }
-                            return 0;
-                        }
-
-                        default:
-                            printf("Unknown type for argument 1 of test '%s'\n", spec->name);
-                            exit(1);
-                    }
-
-                default:
-                    printf("Unknown return type for test '%s'\n", spec->name);
-                    exit(1);
             }
+        }
+    }
 
-        case 2:
-            switch (spec->return_type) {
-                case INT_RET:
-                    switch (spec->arg_types[0]) {
-                        case INT_ARG:
-                            switch (spec->arg_types[1]) {
-                                case INT_ARG: {
-                                    int (*impl)(int, int) = (int (*)(int, int)) spec->impl_func;
-                                    int (*test)(int, int) = (int (*)(int, int)) spec->test_func;
-                                    for (int i = 0; i < num_args[0]; i++) {
-                                        for (int j = 0; j < num_args[1]; j++) {
-                                            int arg1 = arg_test_vals[0][i];
-                                            int arg2 = arg_test_vals[1][j];
-                                            int actual = impl(arg1, arg2);
-                                            int expected = test(arg1, arg2);
-                                            if (actual != expected) {
-                                                printf(
-                                                    "ERROR: Test %s(%d[0x%x],%d[0x%x]) "
-                                                    "failed...\n...Gives %d[0x%x]. Should be "
-                                                    "%d[0x%x]\n",
-                                                    spec->name, arg1, arg1, arg2, arg2, actual,
-                                                    actual, expected, expected);
-                                                return -1;
-                                            }
-                                        }
-                                    }
-                                    return 0;
-                                }
-
-                                case FLOAT_AS_UNSIGNED_ARG:
-                                case UNSIGNED_ARG: {
-                                    int (*impl)(int, unsigned) =
-                                        (int (*)(int, unsigned)) spec->impl_func;
-                                    int (*test)(int, unsigned) =
-                                        (int (*)(int, unsigned)) spec->test_func;
-                                    for (int i = 0; i < num_args[0]; i++) {
-                                        for (int j = 0; j < num_args[1]; j++) {
-                                            int arg1 = arg_test_vals[0][i];
-                                            unsigned arg2 = arg_test_vals[1][j];
-                                            int actual = impl(arg1, arg2);
-                                            int expected = test(arg1, arg2);
-                                            if (actual != expected) {
-                                                printf(
-                                                    "ERROR: Test %s(%d[0x%x],%u[0x%x]) "
-                                                    "failed...\n...Gives %d[0x%x]. Should be "
-                                                    "%d[0x%x]\n",
-                                                    spec->name, arg1, arg1, arg2, arg2, actual,
-                                                    actual, expected, expected);
-                                                return -1;
-                                            }
-                                        }
-                                    }
-                                    return 0;
-                                }
-
-                                default:
-                                    printf("Unkonwn type for argument 2 of test '%s'\n",
-                                           spec->name);
-                                    exit(1);
-                            }
-
-                        case FLOAT_AS_UNSIGNED_ARG:
-                        case UNSIGNED_ARG:
-                            switch (spec->arg_types[1]) {
-                                case INT_ARG: {
-                                    int (*impl)(unsigned, int) =
-                                        (int (*)(unsigned, int)) spec->impl_func;
-                                    int (*test)(unsigned, int) =
-                                        (int (*)(unsigned, int)) spec->test_func;
-                                    for (int i = 0; i < num_args[0]; i++) {
-                                        for (int j = 0; j < num_args[1]; j++) {
-                                            unsigned arg1 = arg_test_vals[0][i];
-                                            int arg2 = arg_test_vals[1][j];
-                                            int actual = impl(arg1, arg2);
-                                            int expected = test(arg1, arg2);
-                                            if (actual != expected) {
-                                                printf(
-                                                    "ERROR: Test %s(%u[0x%x],%d[0x%x]) "
-                                                    "failed...\n...Gives %d[0x%x]. Should be "
-                                                    "%d[0x%x]\n",
-                                                    spec->name, arg1, arg1, arg2, arg2, actual,
-                                                    actual, expected, expected);
-                                                return -1;
-                                            }
-                                        }
-                                    }
-                                    return 0;
-                                }
-
-                                case FLOAT_AS_UNSIGNED_ARG:
-                                case UNSIGNED_ARG: {
-                                    int (*impl)(unsigned, unsigned) =
-                                        (int (*)(unsigned, unsigned)) spec->impl_func;
-                                    int (*test)(unsigned, unsigned) =
-                                        (int (*)(unsigned, unsigned)) spec->test_func;
-                                    for (int i = 0; i < num_args[0]; i++) {
-                                        for (int j = 0; j < num_args[1]; j++) {
-                                            unsigned arg1 = arg_test_vals[0][i];
-                                            unsigned arg2 = arg_test_vals[1][j];
-                                            int actual = impl(arg1, arg2);
-                                            int expected = test(arg1, arg2);
-                                            if (actual != expected) {
-                                                printf(
-                                                    "ERROR: Test %s(%u[0x%x],%u[0x%x]) "
-                                                    "failed...\n...Gives %d[0x%x]. Should be "
-                                                    "%d[0x%x]\n",
-                                                    spec->name, arg1, arg1, arg2, arg2, actual,
-                                                    actual, expected, expected);
-                                                return -1;
-                                            }
-                                        }
-                                    }
-                                    return 0;
-                                }
-
-                                default:
-                                    printf("Unknown type for argument 2 of test '%s'\n",
-                                           spec->name);
-                                    exit(1);
-                            }
-
-                        default:
-                            printf("Unknown type for argument 1 of test '%s'\n", spec->name);
-                            exit(1);
-                    }
-                case UNSIGNED_RET:
-                    switch (spec->arg_types[0]) {
-                        case INT_ARG:
-                            switch (spec->arg_types[1]) {
-                                case INT_ARG: {
-                                    unsigned (*impl)(int, int) =
-                                        (unsigned (*)(int, int)) spec->impl_func;
-                                    unsigned (*test)(int, int) =
-                                        (unsigned (*)(int, int)) spec->test_func;
-                                    for (int i = 0; i < num_args[0]; i++) {
-                                        for (int j = 0; j < num_args[1]; j++) {
-                                            int arg1 = arg_test_vals[0][i];
-                                            int arg2 = arg_test_vals[1][j];
-                                            unsigned actual = impl(arg1, arg2);
-                                            unsigned expected = test(arg1, arg2);
-                                            if (actual != expected) {
-                                                printf(
-                                                    "ERROR: Test %s(%d[0x%x],%d[0x%x]) "
-                                                    "failed...\n...Gives %u[0x%x]. Should be "
-                                                    "%u[0x%x]\n",
-                                                    spec->name, arg1, arg1, arg2, arg2, actual,
-                                                    actual, expected, expected);
-                                                return -1;
-                                            }
-                                        }
-                                    }
-                                    return 0;
-                                }
-
-                                case FLOAT_AS_UNSIGNED_ARG:
-                                case UNSIGNED_ARG: {
-                                    unsigned (*impl)(int, unsigned) =
-                                        (unsigned (*)(int, unsigned)) spec->impl_func;
-                                    unsigned (*test)(int, unsigned) =
-                                        (unsigned (*)(int, unsigned)) spec->test_func;
-                                    for (int i = 0; i < num_args[0]; i++) {
-                                        for (int j = 0; j < num_args[1]; j++) {
-                                            int arg1 = arg_test_vals[0][i];
-                                            unsigned arg2 = arg_test_vals[1][j];
-                                            unsigned actual = impl(arg1, arg2);
-                                            unsigned expected = test(arg1, arg2);
-                                            if (actual != expected) {
-                                                printf(
-                                                    "ERROR: Test %s(%d[0x%x],%u[0x%x]) "
-                                                    "failed...\n...Gives %u[0x%x]. Should be "
-                                                    "%u[0x%x]\n",
-                                                    spec->name, arg1, arg1, arg2, arg2, actual,
-                                                    actual, expected, expected);
-                                                return -1;
-                                            }
-                                        }
-                                    }
-                                    return 0;
-                                }
-
-                                default:
-                                    printf("Unknown type for argument 2 of test '%s'\n",
-                                           spec->name);
-                                    exit(1);
-                            }
-
-                        case FLOAT_AS_UNSIGNED_ARG:
-                        case UNSIGNED_ARG:
-                            switch (spec->arg_types[1]) {
-                                case INT_ARG: {
-                                    unsigned (*impl)(unsigned, int) =
-                                        (unsigned (*)(unsigned, int)) spec->impl_func;
-                                    unsigned (*test)(unsigned, int) =
-                                        (unsigned (*)(unsigned, int)) spec->test_func;
-                                    for (int i = 0; i < num_args[0]; i++) {
-                                        for (int j = 0; j < num_args[1]; j++) {
-                                            unsigned arg1 = arg_test_vals[0][i];
-                                            int arg2 = arg_test_vals[1][j];
-                                            unsigned actual = impl(arg1, arg2);
-                                            unsigned expected = test(arg1, arg2);
-                                            if (actual != expected) {
-                                                printf(
-                                                    "ERROR: Test %s(%u[0x%x],%d[0x%x]) "
-                                                    "failed...\n...Gives %u[0x%x]. Should be "
-                                                    "%u[0x%x]\n",
-                                                    spec->name, arg1, arg1, arg2, arg2, actual,
-                                                    actual, expected, expected);
-                                                return -1;
-                                            }
-                                        }
-                                    }
-                                    return 0;
-                                }
-
-                                case FLOAT_AS_UNSIGNED_ARG:
-                                case UNSIGNED_ARG: {
-                                    unsigned (*impl)(unsigned, unsigned) =
-                                        (unsigned (*)(unsigned, unsigned)) spec->impl_func;
-                                    unsigned (*test)(unsigned, unsigned) =
-                                        (unsigned (*)(unsigned, unsigned)) spec->test_func;
-                                    for (int i = 0; i < num_args[0]; i++) {
-                                        for (int j = 0; j < num_args[1]; j++) {
-                                            unsigned arg1 = arg_test_vals[0][i];
-                                            unsigned arg2 = arg_test_vals[1][j];
-                                            unsigned actual = impl(arg1, arg2);
-                                            unsigned expected = test(arg1, arg2);
-                                            if (actual != expected) {
-                                                printf(
-                                                    "ERROR: Test %s(%u[0x%x],%u[0x%x]) "
-                                                    "failed...\n...Gives %u[0x%x]. Should be "
-                                                    "%u[0x%x]\n",
-                                                    spec->name, arg1, arg1, arg2, arg2, actual,
-                                                    actual, expected, expected);
-                                                return -1;
-                                            }
-                                        }
-                                    }
-                                    return 0;
-                                }
-
-                                default:
-                                    printf("Unknown type for argument 2 of test '%s'\n",
-                                           spec->name);
-                                    exit(1);
-                            }
-
-                        default:
-                            printf("Unknown type for argument 1 of test '%s'\n", spec->name);
-                            exit(1);
-                    }
-
-                default:
-                    printf("Unknown return type for test '%s'\n", spec->name);
-                    exit(1);
+    unsigned num_threads =
+        opts->num_threads > REDUCE_MIN_THREADS ? opts->num_threads : REDUCE_MIN_THREADS;
+    size_t n = num_threads * REDUCE_CHUNK + REDUCE_MAX_SHORT - 1;
+    int *long_array = malloc(n * sizeof(long_array[0]));
+    if (long_array == NULL) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    int result = 0;
+    for (int fill = -1; fill < 2 && result == 0; fill++) {
+        if (fill < 0) {
+            for (size_t i = 0; i < n; i++) {
+                long_array[i] = sample[i % BENCH_INPUTS];
             }
-
-        case 3:
-            switch (spec->return_type) {
-                case INT_RET:
-                    switch (spec->arg_types[0]) {
-                        case INT_ARG:
-                            switch (spec->arg_types[1]) {
-                                case INT_ARG:
-                                    switch (spec->arg_types[2]) {
-                                        case INT_ARG: {
-                                            int (*impl)(int, int, int) =
-                                                (int (*)(int, int, int)) spec->impl_func;
-                                            int (*test)(int, int, int) =
-                                                (int (*)(int, int, int)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        int arg1 = arg_test_vals[0][i];
-                                                        int arg2 = arg_test_vals[1][j];
-                                                        int arg3 = arg_test_vals[2][k];
-                                                        int actual = impl(arg1, arg2, arg3);
-                                                        int expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%d[0x%x], %d[0x%x], "
-                                                                "%d[0x%x]) failed...\n...Gives "
-                                                                "%d[0x%x]. Should be %d[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-
-                                        case FLOAT_AS_UNSIGNED_ARG:
-                                        case UNSIGNED_ARG: {
-                                            int (*impl)(int, int, unsigned) =
-                                                (int (*)(int, int, unsigned)) spec->impl_func;
-                                            int (*test)(int, int, unsigned) =
-                                                (int (*)(int, int, unsigned)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        int arg1 = arg_test_vals[0][i];
-                                                        int arg2 = arg_test_vals[1][j];
-                                                        unsigned arg3 = arg_test_vals[2][k];
-                                                        int actual = impl(arg1, arg2, arg3);
-                                                        int expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%d[0x%x], %d[0x%x], "
-                                                                "%u[0x%x]) failed...\n...Gives "
-                                                                "%d[0x%x]. Should be %d[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-
-                                        default:
-                                            printf("Unknown type for argument 3 of test '%s'\n",
-                                                   spec->name);
-                                            exit(1);
-                                    }
-
-                                case FLOAT_AS_UNSIGNED_ARG:
-                                case UNSIGNED_ARG: {
-                                    switch (spec->arg_types[2]) {
-                                        case INT_ARG: {
-                                            int (*impl)(int, unsigned, int) =
-                                                (int (*)(int, unsigned, int)) spec->impl_func;
-                                            int (*test)(int, unsigned, int) =
-                                                (int (*)(int, unsigned, int)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        int arg1 = arg_test_vals[0][i];
-                                                        unsigned arg2 = arg_test_vals[1][j];
-                                                        int arg3 = arg_test_vals[2][k];
-                                                        int actual = impl(arg1, arg2, arg3);
-                                                        int expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%d[0x%x], %u[0x%x], "
-                                                                "%d[0x%x]) failed...\n...Gives "
-                                                                "%d[0x%x]. Should be %d[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-
-                                        case FLOAT_AS_UNSIGNED_ARG:
-                                        case UNSIGNED_ARG: {
-                                            int (*impl)(int, unsigned, unsigned) =
-                                                (int (*)(int, unsigned, unsigned)) spec->impl_func;
-                                            int (*test)(int, unsigned, unsigned) =
-                                                (int (*)(int, unsigned, unsigned)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        int arg1 = arg_test_vals[0][i];
-                                                        unsigned arg2 = arg_test_vals[1][j];
-                                                        unsigned arg3 = arg_test_vals[2][k];
-                                                        int actual = impl(arg1, arg2, arg3);
-                                                        int expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%d[0x%x], %u[0x%x], "
-                                                                "%u[0x%x]) failed...\n...Gives "
-                                                                "%d[0x%x]. Should be %d[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-                                        default:
-                                            printf("Unknown type for argument 3 of test '%s'\n",
-                                                   spec->name);
-                                            exit(1);
-                                    }
-                                }
-                                default:
-                                    printf("Error: Unkown type for argument 2 of test '%s'\n",
-                                           spec->name);
-                                    exit(1);
-                            }
-
-                        case FLOAT_AS_UNSIGNED_ARG:
-                        case UNSIGNED_ARG:
-                            switch (spec->arg_types[1]) {
-                                case INT_ARG:
-                                    switch (spec->arg_types[2]) {
-                                        case INT_ARG: {
-                                            int (*impl)(unsigned, int, int) =
-                                                (int (*)(unsigned, int, int)) spec->impl_func;
-                                            int (*test)(unsigned, int, int) =
-                                                (int (*)(unsigned, int, int)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        unsigned arg1 = arg_test_vals[0][i];
-                                                        int arg2 = arg_test_vals[1][j];
-                                                        int arg3 = arg_test_vals[2][k];
-                                                        int actual = impl(arg1, arg2, arg3);
-                                                        int expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%u[0x%x], %d[0x%x], "
-                                                                "%d[0x%x]) failed...\n...Gives "
-                                                                "%d[0x%x]. Should be %d[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-
-                                        case FLOAT_AS_UNSIGNED_ARG:
-                                        case UNSIGNED_ARG: {
-                                            int (*impl)(unsigned, int, unsigned) =
-                                                (int (*)(unsigned, int, unsigned)) spec->impl_func;
-                                            int (*test)(unsigned, int, unsigned) =
-                                                (int (*)(unsigned, int, unsigned)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        int arg1 = arg_test_vals[0][i];
-                                                        int arg2 = arg_test_vals[1][j];
-                                                        unsigned arg3 = arg_test_vals[2][k];
-                                                        int actual = impl(arg1, arg2, arg3);
-                                                        int expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%u[0x%x], %d[0x%x], "
-                                                                "%u[0x%x]) failed...\n...Gives "
-                                                                "%d[0x%x]. Should be %d[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-
-                                        default:
-                                            printf("Unkown type for argument 3 of test '%s'\n",
-                                                   spec->name);
-                                    }
-
-                                case FLOAT_AS_UNSIGNED_ARG:
-                                case UNSIGNED_ARG: {
-                                    switch (spec->arg_types[2]) {
-                                        case INT_ARG: {
-                                            int (*impl)(unsigned, unsigned, int) =
-                                                (int (*)(unsigned, unsigned, int)) spec->impl_func;
-                                            int (*test)(unsigned, unsigned, int) =
-                                                (int (*)(unsigned, unsigned, int)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        unsigned arg1 = arg_test_vals[0][i];
-                                                        unsigned arg2 = arg_test_vals[1][j];
-                                                        int arg3 = arg_test_vals[2][k];
-                                                        int actual = impl(arg1, arg2, arg3);
-                                                        int expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%u[0x%x], %u[0x%x], "
-                                                                "%d[0x%x]) failed...\n...Gives "
-                                                                "%d[0x%x]. Should be %d[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-
-                                        case FLOAT_AS_UNSIGNED_ARG:
-                                        case UNSIGNED_ARG: {
-                                            int (*impl)(unsigned, unsigned, unsigned) = (int (*)(
-                                                unsigned, unsigned, unsigned)) spec->impl_func;
-                                            int (*test)(unsigned, unsigned, unsigned) = (int (*)(
-                                                unsigned, unsigned, unsigned)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        unsigned arg1 = arg_test_vals[0][i];
-                                                        unsigned arg2 = arg_test_vals[1][j];
-                                                        unsigned arg3 = arg_test_vals[2][k];
-                                                        int actual = impl(arg1, arg2, arg3);
-                                                        int expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%u[0x%x], %u[0x%x], "
-                                                                "%u[0x%x]) failed...\n...Gives "
-                                                                "%d[0x%x]. Should be %d[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-                                        default:
-                                            printf("Unknown type for argument 3 of test '%s'\n",
-                                                   spec->name);
-                                            exit(1);
-                                    }
-                                }
-                                default:
-                                    printf("Error: Unkown type for argument 2 of test '%s'\n",
-                                           spec->name);
-                                    exit(1);
-                            }
-
-                        default:
-                            printf("Error: Unknown type for argument 1 of test '%s'\n", spec->name);
-                            exit(1);
-                    }
-
-                case UNSIGNED_RET:
-                    switch (spec->arg_types[0]) {
-                        case INT_ARG:
-                            switch (spec->arg_types[1]) {
-                                case INT_ARG:
-                                    switch (spec->arg_types[2]) {
-                                        case INT_ARG: {
-                                            unsigned (*impl)(int, int, int) =
-                                                (unsigned (*)(int, int, int)) spec->impl_func;
-                                            unsigned (*test)(int, int, int) =
-                                                (unsigned (*)(int, int, int)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        int arg1 = arg_test_vals[0][i];
-                                                        int arg2 = arg_test_vals[1][j];
-                                                        int arg3 = arg_test_vals[2][k];
-                                                        unsigned actual = impl(arg1, arg2, arg3);
-                                                        unsigned expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%d[0x%x], %d[0x%x], "
-                                                                "%d[0x%x]) failed...\n...Gives "
-                                                                "%u[0x%x]. Should be %u[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-
-                                        case FLOAT_AS_UNSIGNED_ARG:
-                                        case UNSIGNED_ARG: {
-                                            unsigned (*impl)(int, int, unsigned) =
-                                                (unsigned (*)(int, int, unsigned)) spec->impl_func;
-                                            unsigned (*test)(int, int, unsigned) =
-                                                (unsigned (*)(int, int, unsigned)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        int arg1 = arg_test_vals[0][i];
-                                                        int arg2 = arg_test_vals[1][j];
-                                                        unsigned arg3 = arg_test_vals[2][k];
-                                                        unsigned actual = impl(arg1, arg2, arg3);
-                                                        unsigned expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%d[0x%x], %d[0x%x], "
-                                                                "%u[0x%x]) failed...\n...Gives "
-                                                                "%d[0x%x]. Should be %u[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-
-                                        default:
-                                            printf("Unknown type for argument 3 of test '%s'\n",
-                                                   spec->name);
-                                            exit(1);
-                                    }
-
-                                case FLOAT_AS_UNSIGNED_ARG:
-                                case UNSIGNED_ARG: {
-                                    switch (spec->arg_types[2]) {
-                                        case INT_ARG: {
-                                            unsigned (*impl)(int, unsigned, int) =
-                                                (unsigned (*)(int, unsigned, int)) spec->impl_func;
-                                            unsigned (*test)(int, unsigned, int) =
-                                                (unsigned (*)(int, unsigned, int)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        int arg1 = arg_test_vals[0][i];
-                                                        unsigned arg2 = arg_test_vals[1][j];
-                                                        int arg3 = arg_test_vals[2][k];
-                                                        unsigned actual = impl(arg1, arg2, arg3);
-                                                        unsigned expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%d[0x%x], %u[0x%x], "
-                                                                "%d[0x%x]) failed...\n...Gives "
-                                                                "%u[0x%x]. Should be %u[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-
-                                        case FLOAT_AS_UNSIGNED_ARG:
-                                        case UNSIGNED_ARG: {
-                                            unsigned (*impl)(int, unsigned, unsigned) =
-                                                (unsigned (*)(int, unsigned,
-                                                              unsigned)) spec->impl_func;
-                                            unsigned (*test)(int, unsigned, unsigned) =
-                                                (unsigned (*)(int, unsigned,
-                                                              unsigned)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        int arg1 = arg_test_vals[0][i];
-                                                        unsigned arg2 = arg_test_vals[1][j];
-                                                        unsigned arg3 = arg_test_vals[2][k];
-                                                        unsigned actual = impl(arg1, arg2, arg3);
-                                                        unsigned expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%d[0x%x], %u[0x%x], "
-                                                                "%u[0x%x]) failed...\n...Gives "
-                                                                "%u[0x%x]. Should be %u[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-                                        default:
-                                            printf("Unknown type for argument 3 of test '%s'\n",
-                                                   spec->name);
-                                            exit(1);
-                                    }
-                                }
-                                default:
-                                    printf("Error: Unkown type for argument 2 of test '%s'\n",
-                                           spec->name);
-                                    exit(1);
-                            }
-
-                        case FLOAT_AS_UNSIGNED_ARG:
-                        case UNSIGNED_ARG:
-                            switch (spec->arg_types[1]) {
-                                case INT_ARG:
-                                    switch (spec->arg_types[2]) {
-                                        case INT_ARG: {
-                                            unsigned (*impl)(unsigned, int, int) =
-                                                (unsigned (*)(unsigned, int, int)) spec->impl_func;
-                                            unsigned (*test)(unsigned, int, int) =
-                                                (unsigned (*)(unsigned, int, int)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        unsigned arg1 = arg_test_vals[0][i];
-                                                        int arg2 = arg_test_vals[1][j];
-                                                        int arg3 = arg_test_vals[2][k];
-                                                        unsigned actual = impl(arg1, arg2, arg3);
-                                                        unsigned expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%u[0x%x], %d[0x%x], "
-                                                                "%d[0x%x]) failed...\n...Gives "
-                                                                "%u[0x%x]. Should be %u[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-
-                                        case FLOAT_AS_UNSIGNED_ARG:
-                                        case UNSIGNED_ARG: {
-                                            unsigned (*impl)(unsigned, int, unsigned) =
-                                                (unsigned (*)(unsigned, int,
-                                                              unsigned)) spec->impl_func;
-                                            unsigned (*test)(unsigned, int, unsigned) =
-                                                (unsigned (*)(unsigned, int,
-                                                              unsigned)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        unsigned arg1 = arg_test_vals[0][i];
-                                                        int arg2 = arg_test_vals[1][j];
-                                                        unsigned arg3 = arg_test_vals[2][k];
-                                                        unsigned actual = impl(arg1, arg2, arg3);
-                                                        unsigned expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%u[0x%x], %d[0x%x], "
-                                                                "%u[0x%x]) failed...\n...Gives "
-                                                                "%u[0x%x]. Should be %u[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-
-                                        default:
-                                            printf("Unknown type for argument 3 of test '%s'\n",
-                                                   spec->name);
-                                            exit(1);
-                                    }
-
-                                case FLOAT_AS_UNSIGNED_ARG:
-                                case UNSIGNED_ARG: {
-                                    switch (spec->arg_types[2]) {
-                                        case INT_ARG: {
-                                            unsigned (*impl)(unsigned, unsigned, int) =
-                                                (unsigned (*)(unsigned, unsigned,
-                                                              int)) spec->impl_func;
-                                            unsigned (*test)(unsigned, unsigned, int) =
-                                                (unsigned (*)(unsigned, unsigned,
-                                                              int)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        unsigned arg1 = arg_test_vals[0][i];
-                                                        unsigned arg2 = arg_test_vals[1][j];
-                                                        int arg3 = arg_test_vals[2][k];
-                                                        unsigned actual = impl(arg1, arg2, arg3);
-                                                        unsigned expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%u[0x%x], %u[0x%x], "
-                                                                "%d[0x%x]) failed...\n...Gives "
-                                                                "%u[0x%x]. Should be %u[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-
-                                        case FLOAT_AS_UNSIGNED_ARG:
-                                        case UNSIGNED_ARG: {
-                                            unsigned (*impl)(unsigned, unsigned, unsigned) =
-                                                (unsigned (*)(unsigned, unsigned,
-                                                              unsigned)) spec->impl_func;
-                                            unsigned (*test)(unsigned, unsigned, unsigned) =
-                                                (unsigned (*)(unsigned, unsigned,
-                                                              unsigned)) spec->test_func;
-                                            for (int i = 0; i < num_args[0]; i++) {
-                                                for (int j = 0; j < num_args[1]; j++) {
-                                                    for (int k = 0; k < num_args[2]; k++) {
-                                                        unsigned arg1 = arg_test_vals[0][i];
-                                                        unsigned arg2 = arg_test_vals[1][j];
-                                                        unsigned arg3 = arg_test_vals[2][k];
-                                                        unsigned actual = impl(arg1, arg2, arg3);
-                                                        unsigned expected = test(arg1, arg2, arg3);
-                                                        if (actual != expected) {
-                                                            printf(
-                                                                "ERROR Test %s(%u[0x%x], %u[0x%x], "
-                                                                "%u[0x%x]) failed...\n...Gives "
-                                                                "%u[0x%x]. Should be %u[0x%x]\n",
-                                                                spec->name, arg1, arg1, arg2, arg2,
-                                                                arg3, arg3, actual, actual,
-                                                                expected, expected);
-                                                            return -1;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                            return 0;
-                                        }
-                                        default:
-                                            printf("Unknown type for argument 3 of test '%s'\n",
-                                                   spec->name);
-                                            exit(1);
-                                    }
-                                }
-                                default:
-                                    printf("Error: Unkown type for argument 2 of test '%s'\n",
-                                           spec->name);
-                                    exit(1);
-                            }
-
-                        default:
-                            printf("Error: Unknown type for argument 1 of test '%s'\n", spec->name);
-                            exit(1);
-                    }
-
-                default:
-                    printf("Unknown return type for test '%s'\n", spec->name);
-                    exit(1);
+        } else if (found[0] && found[1]) {
+            for (size_t i = 0; i < n; i++) {
+                long_array[i] = values[i == n - 1 ? !fill : fill];
             }
-
-        default:
-            printf(
-                "Error: Test cases with more than 3 arguments are not "
-                "supported\n");
-            exit(1);
+        } else {
+            break;
+        }
+        for (int op = 0; op < NUM_REDUCE_OPS && result == 0; op++) {
+            result = reduce_check(r, op, long_array, n, num_threads);
+        }
     }
+    free(long_array);
+    return result;
 }
 
 /*
  * get_num_val - Extract hex/decimal/or float value from string
- * *valp must be initialized to 0
  */
-static int get_num_val(char *sval, unsigned *valp) {
+static int get_num_val(char *sval, input_arg_t *valp) {
     char *endp;
 
     /* See if it's an integer or floating point */
@@ -1213,89 +2357,538 @@ static int get_num_val(char *sval, unsigned *valp) {
     }
     if (isfloat) {
         float fval = strtof(sval, &endp);
+        double dval = strtod(sval, &endp);
         if (!*endp) {
-            *valp = *(unsigned *) &fval;
+            memcpy(&valp->float_val, &fval, sizeof(valp->float_val));
+            memcpy(&valp->val, &dval, sizeof(valp->val));
+            valp->is_float = true;
             return 1;
         }
         return 0;
     } else {
-        long llval = strtol(sval, &endp, 0);
-        long upperbits = llval >> 31;
-        /* will give -1 for negative, 0 or 1 for positive */
-        if (!*valp && (upperbits == 0 || upperbits == -1 || upperbits == 1)) {
-            *valp = (unsigned) llval;
-            return 1;
+        /* Negative values must fit in a long, others in an unsigned long,
+           so 64-bit patterns like 0xFFFFFFFFFFFFFFFF can be given too.
+           Whether the value fits the argument is checked once the puzzle
+           is known */
+        errno = 0;
+        if (sval[0] == '-') {
+            valp->val = strtol(sval, &endp, 0);
+        } else {
+            valp->val = strtoul(sval, &endp, 0);
+        }
+        return errno == 0;
+    }
+}
+
+/*
+ * puzzle_selected - Check whether spec's name matches one of the
+ * puzzle names or globs given with --all, or if none were given
+ */
+static bool puzzle_selected(const puzzle_spec_t *spec, char *patterns[], int num_patterns) {
+    if (num_patterns == 0) {
+        return true;
+    }
+    for (int i = 0; i < num_patterns; i++) {
+        if (fnmatch(patterns[i], spec->name, 0) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * any_puzzle_matches - Check whether a puzzle name or glob given with
+ * --all selects at least one puzzle
+ */
+static bool any_puzzle_matches(char *pattern) {
+    for (puzzle_spec_t *current = puzzle_specs; current->name != NULL; current++) {
+        if (puzzle_selected(current, &pattern, 1)) {
+            return true;
         }
-        return 0;
     }
+    return false;
+}
+
+/*
+ * usage - Print command line help
+ */
+static void usage(char *prog) {
+    printf("Usage: %s [options] [func_name] [arg1] [arg2] [arg3]\n", prog);
+    printf("       %s --all [options] [name_or_glob ...]\n", prog);
+    printf("Options:\n");
+    printf("  -j, --jobs N    Split each sweep across N threads\n");
+    printf("  --exhaustive    Test 32-bit single-argument puzzles on every possible input\n");
+    printf("                  (uses all online CPUs unless -j is given)\n");
+    printf("  --batch         Test the batched (func_name_n) implementations\n");
+    printf("  --reference-oracle\n");
+    printf("                  Check the oracles against their slower reference versions\n");
+    printf("                  instead of testing the implementations\n");
+    printf("  --bench         Report cycles per call for each implementation and its\n");
+    printf("                  oracle (with --batch, for the batched implementations)\n");
+    printf("  --perf          Report hardware counters per call for each implementation:\n");
+    printf("                  cycles, instructions, IPC, branches, branch-miss rate and\n");
+    printf("                  L1D misses (time stamp counter cycles only if unavailable)\n");
+    printf("  --bench-orders  Report cycles per call for each implementation on the same\n");
+    printf("                  inputs in sweep, sorted, shuffled, class-alternating and\n");
+    printf("                  adversarial order (classes are the regions of the inputs)\n");
+    printf("  --seed N        Seed for the randomly sampled test values (default 0)\n");
+    printf("  --keep-going[=N]\n");
+    printf("                  Count every failing test instead of stopping at the first,\n");
+    printf("                  then list the first N (default %d, at most %d)\n",
+           DEFAULT_SHOWN_MISMATCHES, MAX_KEPT_MISMATCHES);
+    printf("  --all           Test every puzzle matching one of the given names or\n");
+    printf("                  globs (every puzzle if none are given) in one run\n");
+    printf("  --format=FMT    Report results as 'text' (default) or as 'json', one\n");
+    printf("                  line per puzzle with its test count and elapsed time\n");
+    printf("  --abi-check     Call each implementation through a trampoline that checks\n");
+    printf("                  it preserves the callee-saved registers and stays out of\n");
+    printf("                  its caller's frame\n");
+    printf("  --variants      Also test or time the versions of each puzzle that use\n");
+    printf("                  BMI1, BMI2 or POPCNT, and its func_name_auto entry point,\n");
+    printf("                  which calls the best of them the CPU supports (with --batch,\n");
+    printf("                  the AVX-512 versions and func_name_n_auto). Versions the\n");
+    printf("                  CPU can't run are skipped, with a note unless --all is given\n");
+    printf("  --reduce        Test the count_, any_ and all_ reductions of the predicate\n");
+    printf("                  puzzles (allOddBits, anyEvenBit, isPositive, isPower2)\n");
+    printf("                  against their oracles, splitting long arrays across at\n");
+    printf("                  least %d threads (more with -j)\n", REDUCE_MIN_THREADS);
+    printf("  --library PATH  Test, time or check the functions a libbits.so exports,\n");
+    printf("                  with the symbol versions in libbits.h, instead of the\n");
+    printf("                  ones linked into btest. PATH can be a soname like\n");
+    printf("                  libbits.so.%d to load the installed library\n", LIBBITS_SOVERSION);
+    printf("  --throughput    Report GB/s for each batched implementation streaming\n");
+    printf("                  through %lu MiB arrays, in place for single-argument puzzles\n",
+           THROUGHPUT_BYTES >> 20);
+    printf("The 64-bit puzzles (func_name64, doubleIsEqual, doubleScale2) have no batched\n");
+    printf("versions and are skipped by --exhaustive, --bench, --perf, --bench-orders and\n");
+    printf("--throughput\n");
 }
 
 int main(int argc, char *argv[]) {
     char *puzzle_name = NULL;
-    unsigned arg1 = 0;
-    unsigned arg2 = 0;
-    unsigned arg3 = 0;
-    unsigned *args[] = {NULL, NULL, NULL};
-
-    switch (argc) {
-        case 5:
-            if (get_num_val(argv[4], &arg3) != 0) {
+    input_arg_t arg1 = {0};
+    input_arg_t arg2 = {0};
+    input_arg_t arg3 = {0};
+    input_arg_t *args[] = {NULL, NULL, NULL};
+    int status = 0;
+    test_options_t opts = {
+        .num_threads = 0,
+        .exhaustive = false,
+        .batch = false,
+        .reference = false,
+        .bench = false,
+        .perf = false,
+        .bench_orders = false,
+        .seed = 0,
+        .max_shown = 0,
+        .all = false,
+        .json = false,
+        .abi_check = false,
+        .variants = false,
+        .throughput = false,
+        .reduce = false,
+        .library = NULL,
+        .library_handle = NULL,
+    };
+
+    // Output is fully buffered off a terminal, so without this whatever was
+    // printed before a puzzle crashes would be lost when testius reads it
+    // through a pipe
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    static struct option long_opts[] = {
+        {"jobs", required_argument, NULL, 'j'},
+        {"exhaustive", no_argument, NULL, OPT_EXHAUSTIVE},
+        {"batch", no_argument, NULL, OPT_BATCH},
+        {"reference-oracle", no_argument, NULL, OPT_REFERENCE_ORACLE},
+        {"bench", no_argument, NULL, OPT_BENCH},
+        {"perf", no_argument, NULL, OPT_PERF},
+        {"bench-orders", no_argument, NULL, OPT_BENCH_ORDERS},
+        {"seed", required_argument, NULL, OPT_SEED},
+        {"keep-going", optional_argument, NULL, OPT_KEEP_GOING},
+        {"all", no_argument, NULL, OPT_ALL},
+        {"format", required_argument, NULL, OPT_FORMAT},
+        {"abi-check", no_argument, NULL, OPT_ABI_CHECK},
+        {"variants", no_argument, NULL, OPT_VARIANTS},
+        {"throughput", no_argument, NULL, OPT_THROUGHPUT},
+        {"reduce", no_argument, NULL, OPT_REDUCE},
+        {"library", required_argument, NULL, OPT_LIBRARY},
+        {NULL, 0, NULL, 0},
+    };
+    int opt;
+    /* The leading '+' stops option parsing at the puzzle name, so negative
+       puzzle arguments like '-5' are not mistaken for options */
+    while ((opt = getopt_long(argc, argv, "+j:", long_opts, NULL)) != -1) {
+        switch (opt) {
+            case 'j': {
+                char *endp;
+                long num_threads = strtol(optarg, &endp, 10);
+                if (*endp != '\0' || num_threads < 1 || num_threads > MAX_THREADS) {
+                    printf("Invalid number of threads: '%s'\n", optarg);
+                    exit(1);
+                }
+                opts.num_threads = num_threads;
+                break;
+            }
+
+            case OPT_EXHAUSTIVE:
+                opts.exhaustive = true;
+                break;
+
+            case OPT_BATCH:
+                opts.batch = true;
+                break;
+
+            case OPT_REFERENCE_ORACLE:
+                opts.reference = true;
+                break;
+
+            case OPT_BENCH:
+                opts.bench = true;
+                break;
+
+            case OPT_PERF:
+                opts.perf = true;
+                break;
+
+            case OPT_BENCH_ORDERS:
+                opts.bench_orders = true;
+                break;
+
+            case OPT_KEEP_GOING: {
+                opts.max_shown = DEFAULT_SHOWN_MISMATCHES;
+                if (optarg != NULL) {
+                    char *endp;
+                    long max_shown = strtol(optarg, &endp, 10);
+                    if (*endp != '\0' || max_shown < 1 || max_shown > MAX_KEPT_MISMATCHES) {
+                        printf("Invalid number of failures to show: '%s'\n", optarg);
+                        exit(1);
+                    }
+                    opts.max_shown = max_shown;
+                }
+                break;
+            }
+
+            case OPT_ALL:
+                opts.all = true;
+                break;
+
+            case OPT_FORMAT:
+                if (strcmp(optarg, "json") == 0) {
+                    opts.json = true;
+                } else if (strcmp(optarg, "text") != 0) {
+                    printf("Invalid output format: '%s'\n", optarg);
+                    exit(1);
+                }
+                break;
+
+            case OPT_ABI_CHECK:
+                opts.abi_check = true;
+                break;
+
+            case OPT_VARIANTS:
+                opts.variants = true;
+                break;
+
+            case OPT_THROUGHPUT:
+                opts.throughput = true;
+                break;
+
+            case OPT_REDUCE:
+                opts.reduce = true;
+                break;
+
+            case OPT_LIBRARY:
+                opts.library = optarg;
+                break;
+
+            case OPT_SEED: {
+                char *endp;
+                opts.seed = strtoul(optarg, &endp, 0);
+                if (*endp != '\0' || optarg[0] == '-' || optarg[0] == '\0') {
+                    printf("Invalid seed: '%s'\n", optarg);
+                    exit(1);
+                }
+                break;
+            }
+
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+    char **pos_args = argv + optind;
+
+    if (opts.num_threads == 0) {
+        opts.num_threads = 1;
+        if (opts.exhaustive) {
+            long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            if (num_cpus > MAX_THREADS) {
+                num_cpus = MAX_THREADS;
+            }
+            if (num_cpus > 1) {
+                opts.num_threads = num_cpus;
+            }
+        }
+    }
+    if (opts.throughput && (opts.bench || opts.perf || opts.bench_orders || opts.exhaustive ||
+                            opts.reference || opts.json || opts.abi_check)) {
+        printf("Error: --throughput cannot be combined with --bench, --perf, --bench-orders, "
+               "--exhaustive, --reference-oracle, --format=json or --abi-check\n");
+        exit(1);
+    }
+    if (opts.reduce && (opts.exhaustive || opts.batch || opts.reference || opts.bench ||
+                        opts.perf || opts.bench_orders || opts.throughput || opts.json ||
+                        opts.abi_check || opts.variants)) {
+        printf("Error: --reduce cannot be combined with --exhaustive, --batch, "
+               "--reference-oracle, --bench, --perf, --bench-orders, --throughput, "
+               "--format=json, --abi-check or --variants\n");
+        exit(1);
+    }
+    if (opts.library != NULL && opts.reference) {
+        printf("Error: --library cannot be combined with --reference-oracle\n");
+        exit(1);
+    }
+    if (opts.library != NULL) {
+        // A name without a slash is searched for like any shared library,
+        // so an installed libbits.so.1 is found by its soname
+        opts.library_handle = dlopen(opts.library, RTLD_NOW | RTLD_LOCAL);
+        if (opts.library_handle == NULL) {
+            printf("Error: Cannot load %s: %s\n", opts.library, dlerror());
+            exit(1);
+        }
+    }
+    if (opts.throughput) {
+        // Only the batched implementations stream through arrays
+        opts.batch = true;
+    }
+    if (opts.batch && opts.reference) {
+        printf("Error: --batch cannot be combined with --reference-oracle\n");
+        exit(1);
+    }
+    if (opts.bench && (opts.exhaustive || opts.reference)) {
+        printf("Error: --bench cannot be combined with --exhaustive or --reference-oracle\n");
+        exit(1);
+    }
+    if (opts.bench && opts.json) {
+        printf("Error: --bench cannot be combined with --format=json\n");
+        exit(1);
+    }
+    if (opts.perf && (opts.bench || opts.exhaustive || opts.reference || opts.json)) {
+        printf("Error: --perf cannot be combined with --bench, --exhaustive, "
+               "--reference-oracle or --format=json\n");
+        exit(1);
+    }
+    if (opts.bench_orders &&
+        (opts.bench || opts.perf || opts.exhaustive || opts.reference || opts.json)) {
+        printf("Error: --bench-orders cannot be combined with --bench, --perf, --exhaustive, "
+               "--reference-oracle or --format=json\n");
+        exit(1);
+    }
+    if (opts.abi_check && (opts.exhaustive || opts.batch || opts.reference || opts.bench ||
+                           opts.perf || opts.bench_orders)) {
+        printf("Error: --abi-check cannot be combined with --exhaustive, --batch, "
+               "--reference-oracle, --bench, --perf or --bench-orders\n");
+        exit(1);
+    }
+    if (opts.variants && opts.reference) {
+        printf("Error: --variants cannot be combined with --reference-oracle\n");
+        exit(1);
+    }
+    if (opts.exhaustive && !opts.all && argc - optind > 1) {
+        printf("Error: Function arguments cannot be combined with --exhaustive\n");
+        exit(1);
+    }
+
+    // With --all, the positional arguments are puzzle names or globs
+    char **patterns = opts.all ? pos_args : NULL;
+    int num_patterns = opts.all ? argc - optind : 0;
+    switch (opts.all ? 0 : argc - optind) {
+        case 4:
+            if (get_num_val(pos_args[3], &arg3) != 0) {
                 args[2] = &arg3;
             } else {
-                printf("Invalid input for function argument 3: '%s'\n", argv[4]);
+                printf("Invalid input for function argument 3: '%s'\n", pos_args[3]);
                 exit(1);
             }
             // Fall through
 
-        case 4:
-            if (get_num_val(argv[3], &arg2) != 0) {
+        case 3:
+            if (get_num_val(pos_args[2], &arg2) != 0) {
                 args[1] = &arg2;
             } else {
-                printf("Invalid input for function argument 2: '%s'\n", argv[3]);
+                printf("Invalid input for function argument 2: '%s'\n", pos_args[2]);
                 exit(1);
             }
             // Fall through
 
-        case 3:
-            if (get_num_val(argv[2], &arg1) != 0) {
+        case 2:
+            if (get_num_val(pos_args[1], &arg1) != 0) {
                 args[0] = &arg1;
             } else {
-                printf("Invalid input for function argument 1: '%s'\n", argv[2]);
+                printf("Invalid input for function argument 1: '%s'\n", pos_args[1]);
                 exit(1);
             }
             // Fall through
 
-        case 2:
-            puzzle_name = argv[1];
+        case 1:
+            puzzle_name = pos_args[0];
             break;
 
-        case 1:
+        case 0:
             // Do Nothing
             break;
 
         default:
-            printf("Usage: %s <func_name> [arg1] [arg2] [arg3]\n", argv[0]);
+            usage(argv[0]);
+            exit(1);
+    }
+
+    for (int i = 0; i < num_patterns; i++) {
+        if (!any_puzzle_matches(patterns[i])) {
+            printf("Error: No puzzle matches '%s'\n", patterns[i]);
             exit(1);
+        }
+    }
+
+    // The batched implementations and the reductions are AVX2 code.
+    // Without it there is nothing to test, which is not a failure, so
+    // like the variants the CPU can't run they are skipped, with a note
+    // unless --all is given
+    if ((opts.batch || opts.reduce) && !__builtin_cpu_supports("avx2")) {
+        if (!opts.json && !opts.all) {
+            printf("Skipping the %s, the CPU lacks AVX2\n",
+                   opts.reduce ? "reductions" : "batched implementations");
+        }
+        return 0;
     }
 
-    if (puzzle_name != NULL) {
+    if (opts.reduce) {
+        puzzle_spec_t *current = puzzle_specs;
+        while (current->name != NULL) {
+            bool named = puzzle_name != NULL && strcmp(current->name, puzzle_name) == 0;
+            const reduction_t *r = find_reduction(current->name);
+            if (named && r == NULL) {
+                printf("Error: Puzzle '%s' has no reductions\n", puzzle_name);
+                exit(1);
+            }
+            bool selected =
+                named || (puzzle_name == NULL && puzzle_selected(current, patterns, num_patterns));
+            if (r != NULL && selected) {
+                reduction_t lib_r = library_reduction(r, &opts);
+                status |= test_reductions(current, &lib_r, args, &opts);
+                if (named) {
+                    return status != 0;
+                }
+            }
+            current++;
+        }
+        if (puzzle_name != NULL) {
+            printf("Error: No puzzle with name '%s' found\n", puzzle_name);
+            return 1;
+        }
+    } else if (opts.bench || opts.perf || opts.bench_orders || opts.throughput) {
+        unsigned overhead = 0;
+        int perf_fds[NUM_PERF_COUNTERS];
+        if (opts.perf) {
+            if (!perf_open(perf_fds)) {
+                printf("Hardware counters are unavailable (%s), "
+                       "only time stamp counter cycles are reported\n",
+                       strerror(errno));
+                for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+                    perf_fds[i] = -1;
+                }
+            }
+            print_perf_header(&opts);
+        } else if (opts.bench_orders) {
+            overhead = timer_overhead();
+            print_bench_orders_header(&opts);
+        } else if (opts.throughput) {
+            print_throughput_header();
+        } else {
+            overhead = timer_overhead();
+            print_bench_header(&opts);
+        }
+        puzzle_spec_t *current = puzzle_specs;
+        while (current->name != NULL) {
+            bool named = puzzle_name != NULL && strcmp(current->name, puzzle_name) == 0;
+            if (named && puzzle_is_64bit(current)) {
+                printf("Error: Only 32-bit puzzles can be benchmarked\n");
+                exit(1);
+            }
+            if (puzzle_is_64bit(current)) {
+                // The benchmarks lay their inputs out as 32-bit arrays
+            } else if (named ||
+                       (puzzle_name == NULL && puzzle_selected(current, patterns, num_patterns))) {
+                puzzle_spec_t variants[MAX_VARIANTS];
+                int num_variants = puzzle_variants(current, &opts, variants);
+                for (int i = 0; i < num_variants; i++) {
+                    if (opts.perf) {
+                        perf_function(&variants[i], args, &opts, perf_fds);
+                    } else if (opts.bench_orders) {
+                        bench_orders_function(&variants[i], args, &opts, overhead);
+                    } else if (opts.throughput) {
+                        throughput_function(&variants[i], args, &opts);
+                    } else {
+                        bench_function(&variants[i], args, &opts, overhead);
+                    }
+                }
+                if (named) {
+                    return 0;
+                }
+            }
+            current++;
+        }
+        if (puzzle_name != NULL) {
+            printf("Error: No puzzle with name '%s' found\n", puzzle_name);
+            return 1;
+        }
+    } else if (puzzle_name != NULL) {
         // User has specified one puzzle to test
         puzzle_spec_t *current = puzzle_specs;
         while (current->name != NULL) {
             if (strcmp(current->name, puzzle_name) == 0) {
-                test_function(current, args);
-                return 0;
+                if (opts.reference && current->ref_func == NULL) {
+                    printf("Error: Puzzle '%s' has no reference oracle\n", puzzle_name);
+                    exit(1);
+                }
+                if (opts.batch && current->batch_func == NULL) {
+                    printf("Error: Puzzle '%s' has no batched implementation\n", puzzle_name);
+                    exit(1);
+                }
+                puzzle_spec_t variants[MAX_VARIANTS];
+                int num_variants = puzzle_variants(current, &opts, variants);
+                for (int i = 0; i < num_variants; i++) {
+                    status |= run_puzzle(&variants[i], args, &opts);
+                }
+                return status != 0;
             }
             current++;
         }
 
         printf("Error: No puzzle with name '%s' found\n", puzzle_name);
+        return 1;
     } else {
         puzzle_spec_t *current = puzzle_specs;
         while (current->name != NULL) {
-            test_function(current, args);
+            if (!puzzle_selected(current, patterns, num_patterns)) {
+                // Not asked for with --all
+            } else if (opts.reference && current->ref_func == NULL) {
+                // Nothing to cross-check, the oracle is its own reference
+            } else if (opts.batch && current->batch_func == NULL) {
+                // Nothing to test, the 64-bit puzzles have no batched versions
+            } else if (!opts.exhaustive ||
+                       (current->num_args == 1 && !puzzle_is_64bit(current))) {
+                // Only 32-bit single-argument puzzles have a small enough input
+                // space to test exhaustively
+                puzzle_spec_t variants[MAX_VARIANTS];
+                int num_variants = puzzle_variants(current, &opts, variants);
+                for (int i = 0; i < num_variants; i++) {
+                    status |= run_puzzle(&variants[i], args, &opts);
+                }
+            }
             current++;
         }
     }
-    return 0;
+    return status != 0;
 }
@@ -0,0 +1,99 @@
+#! /bin/bash
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Prints everything the result of a test depends on, for its
+# "cache_key_command". Sources are hashed rather than binaries since btest's
+# LTO objects are not reproducible from one build to the next.
+#
+# With --puzzle, for a test of that one puzzle: its own span of bits.s or
+# bits64.s, from its .global to the next one, and a single hash of the
+# harness sources, every source file in this directory other than those
+# two. A span also takes in the span of any puzzle it jumps to a label in,
+# so a shared label such as a common "return 0" is covered too. Editing one
+# puzzle then only reruns that puzzle's test.
+#
+# Otherwise, for a test of the given make targets as a whole: a hash of the
+# Makefile and of every source file the targets are built from. The sources
+# are found by following the prerequisites of the Makefile's rules down to
+# files no rule builds, so a file added to a rule is covered without being
+# listed here.
+# Usage: bash cache_key.sh --puzzle <name>
+#        bash cache_key.sh <target>...
+set -o pipefail
+
+if [ "$1" = "--puzzle" ]; then
+    for file in bits.s bits64.s; do
+        awk -v puzzle="$2" '
+            /^[ \t]*\.global[ \t]/ {
+                owner = $2
+            }
+            {
+                span[owner] = span[owner] $0 "\n"
+            }
+            # Labels defined here, and the labels this span jumps to
+            /^[ \t]*[.A-Za-z_][.A-Za-z_0-9]*:/ {
+                label = $1
+                sub(/:.*/, "", label)
+                defined_in[label] = owner
+            }
+            /^[ \t]*j[a-z]*[ \t]/ {
+                targets[owner] = targets[owner] " " $2
+            }
+            function visit(name,    n, labels, i) {
+                if (name in seen || !(name in span)) {
+                    return
+                }
+                seen[name] = 1
+                printf "%s", span[name]
+                n = split(targets[name], labels, " ")
+                for (i = 1; i <= n; i++) {
+                    if (labels[i] in defined_in) {
+                        visit(defined_in[labels[i]])
+                    }
+                }
+            }
+            END {
+                if (puzzle in span) {
+                    visit(puzzle)
+                }
+            }' "$file" || exit 1
+    done
+    sources=$(ls Makefile *.c *.h *.s *.inc | grep -v -x -e bits.s -e bits64.s) || exit 1
+    cat $sources | sha256sum
+    exit
+fi
+
+# make -q exits with 1 when a target is out of date, which is fine here
+database=$(make -qp "$@" 2>/dev/null)
+if [ $? -gt 1 ]; then
+    exit 1
+fi
+
+sources=$(awk -v targets="$*" '
+    # Rules look like "target: prerequisites". Skip comments, recipes,
+    # variable assignments, special targets and pattern rules
+    /^[^#\t. ][^:=% ]*:( |$)/ && !/^[^:]*:=/ {
+        target = substr($1, 1, length($1) - 1)
+        prereqs[target] = substr($0, length($1) + 2)
+    }
+    function visit(name,    n, deps, i) {
+        if (name in seen) {
+            return
+        }
+        seen[name] = 1
+        if (prereqs[name] == "") {
+            print name
+            return
+        }
+        n = split(prereqs[name], deps, " ")
+        for (i = 1; i <= n; i++) {
+            visit(deps[i])
+        }
+    }
+    END {
+        n = split(targets, roots, " ")
+        for (i = 1; i <= n; i++) {
+            visit(roots[i])
+        }
+    }' <<< "$database" | sort) || exit 1
+
+sha256sum Makefile $sources
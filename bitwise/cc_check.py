@@ -58,9 +58,12 @@ if not os.path.isfile(assembly_filename):
 if not os.path.isfile(puzzle_list_filename):
     print_error_and_exit(puzzle_list_filename + " does not exist", 2)
 
-# Obtain puzzle names from JSON file
+# Obtain puzzle names from JSON file. Entries are either a name or an
+# object with a "name" and the puzzle's cost budgets for cost_report.py
 with open(puzzle_list_filename) as f:
-    function_names = json.load(f)
+    function_names = [
+        entry if isinstance(entry, str) else entry["name"] for entry in json.load(f)
+    ]
 
 # Init callee register map
 # False = Register not on stack
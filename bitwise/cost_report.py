@@ -0,0 +1,511 @@
+#!/usr/bin/env python3
+
+# SPDX-License-Identifier: GPL-3.0-or-later
+
+## -----------------------------------------------------------------------------
+## Script to estimate the cost of each puzzle in an assembly file without
+## running it. Every path from a puzzle's entry to a ret is reported with its
+## instruction count, the latency of its longest dependency chain and a
+## throughput bound from the execution ports its uops need. Puzzles in the
+## puzzle list may carry budgets for these, which are checked.
+##
+## The numbers come from a simple model of a Skylake-class core: fixed
+## latencies and ports per instruction, perfect branch prediction, no
+## macro-fusion and no cost for the call itself. They are meant for comparing
+## versions of the same code, not for predicting exact cycle counts.
+## -----------------------------------------------------------------------------
+
+import argparse
+import itertools
+import json
+import os
+import sys
+
+# Register names by width, for mapping every register to its 64-bit name
+REGISTERS_64 = ["rax", "rbx", "rcx", "rdx", "rsi", "rdi", "rbp", "rsp"]
+REGISTERS_32 = ["eax", "ebx", "ecx", "edx", "esi", "edi", "ebp", "esp"]
+REGISTERS_16 = ["ax", "bx", "cx", "dx", "si", "di", "bp", "sp"]
+REGISTERS_8 = ["al", "bl", "cl", "dl", "sil", "dil", "bpl", "spl"]
+REGISTERS_8_HIGH = ["ah", "bh", "ch", "dh"]
+
+# Pseudo-register for the flags, so dependencies through them are tracked
+# like those through registers. Memory operands are tracked by their text
+FLAGS = "flags"
+
+# Latency added to an instruction that reads a memory operand, and the
+# store-to-load forwarding latency of reading back a value just stored
+LOAD_LATENCY = 5
+FORWARD_LATENCY = 4
+
+# Uops the front end can issue per cycle
+ISSUE_WIDTH = 4
+
+# Latency in cycles and the ports each uop can execute on, by mnemonic
+# without its size suffix. Ports 0, 1, 5 and 6 are ALUs, 2 and 3 load, 4
+# stores data and 7 computes store addresses
+ALU = (1, ["0156"])
+SHIFT = (1, ["06"])
+SHIFT_BY_CL = (2, ["06", "06"])
+BRANCH = (1, ["06"])
+SLOW_INT = (3, ["1"])
+INSTRUCTION_COSTS = {
+    "mov": ALU,
+    "movabs": ALU,
+    "movzb": ALU,
+    "movzw": ALU,
+    "movsb": ALU,
+    "movsw": ALU,
+    "movsl": ALU,
+    "add": ALU,
+    "sub": ALU,
+    "and": ALU,
+    "or": ALU,
+    "xor": ALU,
+    "not": ALU,
+    "neg": ALU,
+    "inc": ALU,
+    "dec": ALU,
+    "cmp": ALU,
+    "test": ALU,
+    "adc": ALU,
+    "sbb": ALU,
+    "lea": (1, ["15"]),
+    "shl": SHIFT,
+    "sal": SHIFT,
+    "shr": SHIFT,
+    "sar": SHIFT,
+    "rol": SHIFT,
+    "ror": SHIFT,
+    "shlx": SHIFT,
+    "shrx": SHIFT,
+    "sarx": SHIFT,
+    "rorx": SHIFT,
+    "bt": SHIFT,
+    "imul": SLOW_INT,
+    "popcnt": SLOW_INT,
+    "lzcnt": SLOW_INT,
+    "tzcnt": SLOW_INT,
+    "bsf": SLOW_INT,
+    "bsr": SLOW_INT,
+    "pdep": SLOW_INT,
+    "pext": SLOW_INT,
+    "andn": (1, ["15"]),
+    "blsi": (1, ["15"]),
+    "blsr": (1, ["15"]),
+    "blsmsk": (1, ["15"]),
+    "bzhi": (1, ["15"]),
+    "bextr": (2, ["06", "15"]),
+    "cltd": (1, ["06"]),
+    "cltq": ALU,
+    "cqto": (1, ["06"]),
+    "set": (1, ["06"]),
+    "cmov": (1, ["06"]),
+    "j": BRANCH,
+    "jmp": (1, ["6"]),
+    "push": (1, ["4", "237"]),
+    "pop": (1, ["23"]),
+    "ret": (1, ["237", "6"]),
+    "nop": (0, []),
+    "div": (26, ["0"] * 10),
+    "idiv": (26, ["0"] * 10),
+}
+
+# Condition code suffixes of jcc, setcc and cmovcc
+CONDITION_CODES = [
+    "o", "no", "b", "c", "nae", "ae", "nb", "nc", "e", "z", "ne", "nz", "be", "na",
+    "a", "nbe", "s", "ns", "p", "pe", "np", "po", "l", "nge", "ge", "nl", "le",
+    "ng", "g", "nle",
+]  # fmt: skip
+
+# Instructions that read their destination as well as writing it
+READS_DESTINATION = {
+    "add", "sub", "and", "or", "xor", "adc", "sbb", "not", "neg", "inc", "dec",
+    "shl", "sal", "shr", "sar", "rol", "ror", "cmov", "bsf", "bsr",
+}  # fmt: skip
+
+# Instructions that only read their operands
+READS_ONLY = {"cmp", "test", "bt", "push", "j", "jmp"}
+
+# Instructions that do not change the flags
+KEEPS_FLAGS = {
+    "mov", "movabs", "movzb", "movzw", "movsb", "movsw", "movsl", "lea", "not", "set",
+    "cmov", "push", "pop", "j", "jmp", "ret", "nop", "cltd", "cltq", "cqto",
+    "shlx", "shrx", "sarx", "rorx", "pdep", "pext",
+}  # fmt: skip
+
+# Instructions that also read the flags
+READS_FLAGS = {"adc", "sbb", "set", "cmov", "j"}
+
+# Longest path enumeration to attempt per puzzle
+MAX_PATHS = 10000
+
+
+# Prints the error_message and exits with failure status
+def print_error_and_exit(error_message, error_number):
+    print("ERROR: " + error_message)
+    sys.exit(error_number)
+
+
+# Returns the 64-bit name of a register name without its %, and whether
+# writing it leaves the rest of the 64-bit register unchanged
+def normalize_register(name):
+    for i, full in enumerate(REGISTERS_64):
+        if name == full or name == REGISTERS_32[i]:
+            return full, False
+        if name == REGISTERS_16[i] or name == REGISTERS_8[i]:
+            return full, True
+    if name in REGISTERS_8_HIGH:
+        return REGISTERS_64[REGISTERS_8_HIGH.index(name)], True
+    if name.startswith("r") and name[1:].rstrip("dwb").isdigit():
+        full = "r" + name[1:].rstrip("dwb")
+        return full, name[-1] in "wb"
+    return name, False
+
+
+# Splits an instruction's operand text on the commas between operands
+def split_operands(text):
+    operands = []
+    depth = 0
+    current = ""
+    for char in text:
+        if char == "," and depth == 0:
+            operands.append(current.strip())
+            current = ""
+            continue
+        depth += {"(": 1, ")": -1}.get(char, 0)
+        current += char
+    if current.strip():
+        operands.append(current.strip())
+    return operands
+
+
+# Returns the registers an operand reads to form its value or address
+def registers_in(operand):
+    registers = []
+    for part in operand.replace("(", ",").replace(")", ",").split(","):
+        part = part.strip()
+        if part.startswith("%"):
+            registers.append(normalize_register(part[1:])[0])
+    return registers
+
+
+# Splits a mnemonic into the base name used by INSTRUCTION_COSTS and the
+# other tables, or returns None for an instruction the model doesn't know
+def base_mnemonic(mnemonic):
+    if mnemonic in INSTRUCTION_COSTS:
+        return mnemonic
+    for prefix in ["j", "set", "cmov"]:
+        rest = mnemonic[len(prefix) :]
+        if mnemonic.startswith(prefix) and (
+            rest in CONDITION_CODES or rest[:-1] in CONDITION_CODES and prefix == "cmov"
+        ):
+            return prefix
+    if mnemonic[-1] in "bwlq" and mnemonic[:-1] in INSTRUCTION_COSTS:
+        return mnemonic[:-1]
+    return None
+
+
+# One instruction of a puzzle, with what the cost model needs to know
+class Instruction:
+    def __init__(self, line_number, mnemonic, operands):
+        self.line_number = line_number
+        self.mnemonic = mnemonic
+        self.operands = operands
+        self.base = base_mnemonic(mnemonic)
+        if self.base is None:
+            print(
+                f"WARNING: Unknown instruction '{mnemonic}' on line {line_number}, "
+                "counted as a simple ALU instruction"
+            )
+        self.latency, self.ports = INSTRUCTION_COSTS.get(self.base, ALU)
+        base = self.base or "mov"
+
+        if base in ["shl", "sal", "shr", "sar", "rol", "ror"] and "%cl" in operands:
+            self.latency, self.ports = SHIFT_BY_CL
+
+        self.reads = []
+        self.writes = []
+        self.loads = []
+        self.stores = []
+        for i, operand in enumerate(operands):
+            is_destination = i == len(operands) - 1 and base not in READS_ONLY
+            if operand.startswith("%"):
+                register, partial = normalize_register(operand[1:])
+                if is_destination:
+                    self.writes.append(register)
+                    if base in READS_DESTINATION or partial:
+                        self.reads.append(register)
+                else:
+                    self.reads.append(register)
+            elif "(" in operand:
+                # The address is always read. Memory operands other than the
+                # destination of a plain store are loaded from
+                self.reads.extend(registers_in(operand))
+                if base == "lea":
+                    continue
+                if is_destination:
+                    self.stores.append(operand)
+                if not is_destination or base in READS_DESTINATION:
+                    self.loads.append(operand)
+
+        # Zeroing idioms like xorl %eax, %eax don't depend on the register
+        if base in ["xor", "sub"] and len(operands) == 2 and operands[0] == operands[1]:
+            self.reads = []
+        # Stack pointer updates by push and pop are handled by the stack
+        # engine, so they don't form a dependency chain through %rsp
+        if base == "pop" and operands:
+            self.writes = [normalize_register(operands[0][1:])[0]]
+        if base == "ret":
+            self.reads = ["rax"]
+        if base in READS_FLAGS:
+            self.reads.append(FLAGS)
+        if base not in KEEPS_FLAGS:
+            self.writes.append(FLAGS)
+        if self.loads:
+            self.latency += LOAD_LATENCY
+            self.ports = self.ports + ["23"]
+        if self.stores and base not in ["push"]:
+            self.ports = self.ports + ["4", "237"]
+
+    def is_branch(self):
+        return self.base in ["j", "jmp"]
+
+
+# A puzzle's code, split into basic blocks keyed by their label, with
+# "entry" for the first one
+class Function:
+    def __init__(self, name):
+        self.name = name
+        self.blocks = {"entry": []}
+        self.block_order = ["entry"]
+        self.falls_through = {}
+        self.current = "entry"
+
+    def add_label(self, label):
+        # A label starts a new block, reached by falling through from the
+        # previous one unless that ended with an unconditional transfer
+        previous = self.blocks[self.current]
+        if not previous or previous[-1].base not in ["jmp", "ret"]:
+            self.falls_through[self.current] = label
+        self.blocks[label] = []
+        self.block_order.append(label)
+        self.current = label
+
+    def add_instruction(self, instruction):
+        block = self.blocks[self.current]
+        if block and block[-1].base in ["j", "jmp", "ret"]:
+            # Code after a branch in the same block starts an unlabeled block
+            label = f"line {instruction.line_number}"
+            self.add_label(label)
+            block = self.blocks[label]
+        block.append(instruction)
+
+
+# Reads the puzzles named in function_names from the assembly file
+def parse_functions(assembly_filename, function_names):
+    functions = {}
+    current = None
+    with open(assembly_filename, "r") as assembly_file:
+        lines = assembly_file.readlines()
+
+    for line_number, line in enumerate(lines, start=1):
+        line = line.split("#")[0].strip()
+        if not line or line.startswith("/"):
+            continue
+        tokens = line.split()
+        if tokens[0] in [".global", ".globl"]:
+            name = tokens[-1]
+            current = Function(name) if name in function_names else None
+            if current is not None:
+                functions[name] = current
+            continue
+        if current is None:
+            continue
+        while ":" in line:
+            label, line = line.split(":", 1)
+            label = label.strip()
+            if label != current.name:
+                current.add_label(label)
+            line = line.strip()
+        if not line or line.startswith("."):
+            continue
+        mnemonic, _, operand_text = line.partition(" ")
+        current.add_instruction(
+            Instruction(line_number, mnemonic, split_operands(operand_text))
+        )
+    return functions
+
+
+# Returns every path through function as a list of block labels, and
+# whether some path had to be cut short at a loop
+def enumerate_paths(function):
+    paths = []
+    has_loop = False
+    stack = [["entry"]]
+    while stack and len(paths) < MAX_PATHS:
+        path = stack.pop()
+        block = function.blocks[path[-1]]
+        successors = []
+        last = block[-1] if block else None
+        if last is not None and last.base == "ret":
+            paths.append(path)
+            continue
+        if last is not None and last.is_branch():
+            target = last.operands[0] if last.operands else None
+            if target not in function.blocks:
+                print_error_and_exit(
+                    f"{function.name}: branch to unknown label '{target}' on line "
+                    f"{last.line_number}",
+                    3,
+                )
+            successors.append(target)
+        if last is None or last.base != "jmp":
+            following = function.falls_through.get(path[-1])
+            if following is None:
+                print_error_and_exit(
+                    f"{function.name}: execution falls off the end after block "
+                    f"'{path[-1]}'",
+                    3,
+                )
+            successors.append(following)
+        # Push the fall-through successor last so it is explored first
+        for successor in reversed(successors):
+            if successor in path:
+                has_loop = True
+            else:
+                stack.append(path + [successor])
+    return paths, has_loop
+
+
+# Returns the cycles the uops need at best given the ports they can use:
+# for every set of ports, the uops that can only use those ports must
+# share them, and all uops must get through the front end
+def port_pressure_bound(port_sets):
+    if not port_sets:
+        return 0.0
+    bound = len(port_sets) / ISSUE_WIDTH
+    distinct = sorted(set(port_sets))
+    for count in range(1, len(distinct) + 1):
+        for combination in itertools.combinations(distinct, count):
+            ports = set("".join(combination))
+            confined = sum(1 for uop in port_sets if set(uop) <= ports)
+            bound = max(bound, confined / len(ports))
+    return bound
+
+
+# The cost of one path through a puzzle
+class PathCost:
+    def __init__(self, function, path):
+        self.path = path
+        instructions = [i for label in path for i in function.blocks[label]]
+        self.num_instructions = sum(1 for i in instructions if i.base != "nop")
+
+        # Each register, the flags and each memory operand become ready
+        # when the instruction that last wrote them finishes
+        ready = {}
+        self.latency = 0
+        for instruction in instructions:
+            start = max([ready.get(r, 0) for r in instruction.reads], default=0)
+            for operand in instruction.loads:
+                if operand in ready:
+                    start = max(start, ready[operand] + FORWARD_LATENCY - LOAD_LATENCY)
+            finish = start + instruction.latency
+            for written in instruction.writes + instruction.stores:
+                ready[written] = finish
+            if instruction.base != "ret":
+                self.latency = max(self.latency, finish)
+
+        self.throughput = port_pressure_bound(
+            [ports for i in instructions for ports in i.ports]
+        )
+
+    # Names the path by the blocks it goes through after the entry block.
+    # Blocks without a label are named after their first line
+    def describe(self):
+        return "via " + ", ".join(self.path[1:]) if len(self.path) > 1 else "straight line"
+
+
+# Checks the worst costs of a puzzle against its budget and returns a
+# list of the budgets it is over
+def check_budget(name, budget, instructions, latency, throughput):
+    over = []
+    limits = [
+        ("max_instructions", instructions, "instr"),
+        ("max_latency", latency, "cycles critical path"),
+        ("max_throughput", throughput, "cycles/call throughput"),
+    ]
+    for key, value, unit in limits:
+        if key in budget and value > budget[key]:
+            over.append(f"{name}: {value:g} {unit} is over its budget of {budget[key]:g}")
+    return over
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Estimate the cost of each puzzle without running it"
+    )
+    parser.add_argument("puzzle_list", help="JSON list of puzzles, with optional budgets")
+    parser.add_argument("assembly_file")
+    parser.add_argument(
+        "-v", "--verbose", action="store_true", help="Report every path, not just the worst"
+    )
+    parser.add_argument(
+        "-q", "--quiet", action="store_true", help="Report only the budgets that are exceeded"
+    )
+    args = parser.parse_args()
+
+    for filename in [args.assembly_file, args.puzzle_list]:
+        if not os.path.isfile(filename):
+            print_error_and_exit(filename + " does not exist", 2)
+
+    # Each entry is either a puzzle name or an object with its name and
+    # budgets, e.g. {"name": "bitAnd", "max_instructions": 8}
+    with open(args.puzzle_list) as f:
+        entries = json.load(f)
+    budgets = {}
+    for entry in entries:
+        if isinstance(entry, str):
+            budgets[entry] = {}
+        else:
+            budgets[entry["name"]] = entry
+
+    functions = parse_functions(args.assembly_file, budgets)
+    over_budget = []
+    for name in budgets:
+        if name not in functions:
+            print(f"{name}: not found in {args.assembly_file}")
+            continue
+        paths, has_loop = enumerate_paths(functions[name])
+        costs = [PathCost(functions[name], path) for path in paths]
+        if not costs:
+            print(f"{name}: no path reaches a ret")
+            continue
+        instructions = max(c.num_instructions for c in costs)
+        latency = max(c.latency for c in costs)
+        throughput = max(c.throughput for c in costs)
+        if len(costs) == 1:
+            paths_text = "1 path"
+        else:
+            paths_text = f"worst of {len(costs)} paths"
+        if has_loop:
+            paths_text += ", loops counted once"
+        if not args.quiet:
+            print(
+                f"{name}: {instructions} instr, ~{latency} cycles critical path, "
+                f"~{throughput:.2f} cycles/call throughput ({paths_text})"
+            )
+        if args.verbose and not args.quiet and len(costs) > 1:
+            for cost in costs:
+                print(
+                    f"    {cost.describe()}: {cost.num_instructions} instr, "
+                    f"~{cost.latency} cycles, ~{cost.throughput:.2f} cycles/call"
+                )
+        over_budget += check_budget(name, budgets[name], instructions, latency, throughput)
+
+    for message in over_budget:
+        print("ERROR: " + message)
+    sys.exit(1 if over_budget else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "bits.h"
+#include "dispatch.h"
+
+#define VARIANT(puzzle, isa, name) {#puzzle, #name, isa, (int (*)(void)) name, false}
+#define BATCH_VARIANT(puzzle, isa, name) {#puzzle, #name, isa, (int (*)(void)) name, true}
+
+const kernel_variant_t kernel_variants[] = {
+    VARIANT(allOddBits, ISA_BMI1, allOddBits_bmi1),
+    VARIANT(bitMask, ISA_BMI1 | ISA_BMI2, bitMask_bmi2),
+    VARIANT(isPower2, ISA_BMI1, isPower2_bmi1),
+    VARIANT(isPower2, ISA_POPCNT, isPower2_popcnt),
+    VARIANT(replaceByte, ISA_BMI1 | ISA_BMI2, replaceByte_bmi2),
+    BATCH_VARIANT(floatIsEqual, ISA_AVX512, floatIsEqual_n_avx512),
+    BATCH_VARIANT(floatScale2, ISA_AVX512, floatScale2_n_avx512),
+    {NULL},
+};
+
+unsigned cpu_isa(void) {
+    // The ifunc resolvers below run before constructors, so the CPU
+    // model data __builtin_cpu_supports() reads may not be set up yet
+    __builtin_cpu_init();
+    unsigned isa = 0;
+    if (__builtin_cpu_supports("bmi")) {
+        isa |= ISA_BMI1;
+    }
+    if (__builtin_cpu_supports("bmi2")) {
+        isa |= ISA_BMI2;
+    }
+    if (__builtin_cpu_supports("popcnt")) {
+        isa |= ISA_POPCNT;
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        isa |= ISA_AVX512;
+    }
+    return isa;
+}
+
+/*
+ * same_name - Return true if the strings a and b are equal. The
+ * resolvers can run before the C library's own ifuncs like strcmp()
+ * are resolved, so they don't call it
+ */
+static bool same_name(const char *a, const char *b) {
+    while (*a != '\0' && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+const kernel_variant_t *best_variant(const char *puzzle, bool batch, unsigned isa) {
+    for (const kernel_variant_t *variant = kernel_variants; variant->puzzle != NULL; variant++) {
+        if (same_name(variant->puzzle, puzzle) && variant->batch == batch &&
+            (variant->isa & ~isa) == 0) {
+            return variant;
+        }
+    }
+    return NULL;
+}
+
+/* The entry points are exported from libbits.so, which is built with
+   everything else in this file hidden */
+#define EXPORTED __attribute__((visibility("default")))
+
+/*
+ * NAME_auto - GNU indirect functions: the dynamic loader calls
+ * resolve_NAME once, when the program is loaded, and binds NAME_auto
+ * to the function it returns. Calls then go straight to the best
+ * variant for the CPU, with no check per call
+ */
+#define DISPATCH(name)                                                        \
+    static __typeof__(&name) resolve_##name(void) {                           \
+        const kernel_variant_t *best = best_variant(#name, false, cpu_isa()); \
+        return best != NULL ? (__typeof__(&name)) best->func : name;          \
+    }                                                                         \
+    EXPORTED __typeof__(name) name##_auto __attribute__((ifunc("resolve_" #name)));
+
+/*
+ * NAME_n_auto - The same for batched implementations. The fallback is
+ * the AVX2 version in bits_n.s, so callers still need AVX2
+ */
+#define DISPATCH_BATCH(name)                                                  \
+    static __typeof__(&name##_n) resolve_##name##_n(void) {                   \
+        const kernel_variant_t *best = best_variant(#name, true, cpu_isa());  \
+        return best != NULL ? (__typeof__(&name##_n)) best->func : name##_n;  \
+    }                                                                         \
+    EXPORTED __typeof__(name##_n) name##_n_auto __attribute__((ifunc("resolve_" #name "_n")));
+
+#define FOR_EACH_DISPATCHED(X) X(allOddBits) X(bitMask) X(isPower2) X(replaceByte)
+#define FOR_EACH_BATCH_DISPATCHED(X) X(floatIsEqual) X(floatScale2)
+
+FOR_EACH_DISPATCHED(DISPATCH)
+FOR_EACH_BATCH_DISPATCHED(DISPATCH_BATCH)
+
+#define DISPATCHED_ENTRY(name) {#name, #name "_auto", 0, (int (*)(void)) name##_auto, false},
+#define BATCH_DISPATCHED_ENTRY(name) \
+    {#name, #name "_n_auto", 0, (int (*)(void)) name##_n_auto, true},
+
+const kernel_variant_t dispatched_kernels[] = {
+    FOR_EACH_DISPATCHED(DISPATCHED_ENTRY)
+    FOR_EACH_BATCH_DISPATCHED(BATCH_DISPATCHED_ENTRY)
+    {NULL},
+};
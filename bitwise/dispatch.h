@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include <stdbool.h>
+
+/* Instruction set extensions a kernel variant can need */
+#define ISA_BMI1 (1u << 0)
+#define ISA_BMI2 (1u << 1)
+#define ISA_POPCNT (1u << 2)
+#define ISA_AVX512 (1u << 3)    // AVX512F
+
+/*
+ * A version of a puzzle's implementation, from bits_bmi.s, or of its
+ * batched implementation, from bits_n512.s, or one of the NAME_auto
+ * entry points that call the best of them
+ */
+typedef struct {
+    const char *puzzle;    // Name of the puzzle in puzzle_specs
+    const char *name;      // Name of the function, e.g. "bitMask_bmi2"
+    unsigned isa;          // ISA_* extensions it needs
+    int (*func)(void);     // Function pointer that will be cast as needed
+    bool batch;            // A version of batch_func rather than impl_func
+} kernel_variant_t;
+
+/* Every variant, best first for each puzzle. Ends with a NULL puzzle */
+extern const kernel_variant_t kernel_variants[];
+
+/* The NAME_auto entry points, with no ISA requirements. Ends with a NULL puzzle */
+extern const kernel_variant_t dispatched_kernels[];
+
+/*
+ * cpu_isa - Return the ISA_* extensions the CPU supports
+ */
+unsigned cpu_isa(void);
+
+/*
+ * best_variant - Return the first variant of puzzle in kernel_variants
+ * that needs only extensions in isa and is a version of batch_func if
+ * batch is set, or of impl_func if not, or NULL if there is none and the
+ * puzzle's plain implementation should be used
+ */
+const kernel_variant_t *best_variant(const char *puzzle, bool batch, unsigned isa);
+
+#endif    // DISPATCH_H
@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+//
+// Public header of libbits.so, the puzzle kernels as a shared library.
+// Link with -lbits. Every function declared in bits.h is exported with
+// the symbol version LIBBITS_1.0 (libbits.map), and callers must check
+// the CPU features listed there before calling a variant that needs
+// them. The NAME_auto entry points check for themselves, once when the
+// library is loaded
+#ifndef LIBBITS_H
+#define LIBBITS_H
+
+// The library's soname is libbits.so.LIBBITS_SOVERSION. It only changes
+// when a function is removed or changed incompatibly without keeping
+// the old version, which programs linked against the old soname need
+#define LIBBITS_SOVERSION 1
+
+// Version node of the symbols the current header declares, for dlvsym()
+#define LIBBITS_VERSION_NODE "LIBBITS_1.0"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "bits.h"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif    // LIBBITS_H
@@ -12,12 +12,7 @@ int test_bitAnd(int x, int y) {
 }
 
 int test_allOddBits(int x) {
-    for (int i = 1; i < 32; i += 2) {
-        if ((x & (1 << i)) == 0) {
-            return 0;
-        }
-    }
-    return 1;
+    return (x & 0xAAAAAAAA) == 0xAAAAAAAA;
 }
 
 int test_floatIsEqual(unsigned uf, unsigned ug) {
@@ -34,12 +29,7 @@ int test_floatIsEqual(unsigned uf, unsigned ug) {
 }
 
 int test_anyEvenBit(int x) {
-    for (int i = 0; i < 32; i += 2) {
-        if (x & (1 << i)) {
-            return 1;
-        }
-    }
-    return 0;
+    return (x & 0x55555555) != 0;
 }
 
 int test_isPositive(int x) {
@@ -70,20 +60,13 @@ int test_isLess(int x, int y) {
 
 int test_rotateLeft(int x, int n) {
     unsigned u = (unsigned) x;
-    for (int i = 0; i < n; i++) {
-        unsigned msb = u >> 31;
-        unsigned rest = u << 1;
-        u = rest | msb;
-    }
-    return (int) u;
+    // Masking the right shift keeps it defined for n == 0, where it ORs in u itself
+    return (int) ((u << n) | (u >> ((32 - n) & 31)));
 }
 
 int test_bitMask(int highbit, int lowbit) {
-    int result = 0;
-    for (int i = lowbit; i <= highbit; i++) {
-        result |= 1 << i;
-    }
-    return result;
+    // Bits at or below highbit, intersected with bits at or above lowbit
+    return (int) ((~0U >> (31 - highbit)) & (~0U << lowbit));
 }
 
 unsigned test_floatScale2(unsigned uf) {
@@ -94,15 +77,139 @@ unsigned test_floatScale2(unsigned uf) {
 
     union unsigned_float x;
     x.u = uf;
+    // Multiplying would quiet a signaling NaN, but NaNs are returned as is
+    if (isnan(x.f)) {
+        return uf;
+    }
     x.f *= 2;
     return x.u;
 }
 
 int test_isPower2(int x) {
+    return x > 0 && (x & (x - 1)) == 0;
+}
+
+/*
+ * 64-bit versions of the oracles above
+ */
+
+long test_bitXor64(long x, long y) {
+    return x ^ y;
+}
+
+long test_bitAnd64(long x, long y) {
+    return x & y;
+}
+
+int test_allOddBits64(long x) {
+    return (x & 0xAAAAAAAAAAAAAAAA) == 0xAAAAAAAAAAAAAAAA;
+}
+
+int test_doubleIsEqual(unsigned long uf, unsigned long ug) {
+    union unsigned_double {
+        unsigned long u;
+        double d;
+    };
+
+    union unsigned_double x;
+    x.u = uf;
+    union unsigned_double y;
+    y.u = ug;
+    return x.d == y.d;
+}
+
+int test_anyEvenBit64(long x) {
+    return (x & 0x5555555555555555) != 0;
+}
+
+int test_isPositive64(long x) {
+    return x > 0;
+}
+
+long test_replaceByte64(long x, int n, int c) {
+    int shift = 8 * n;
+    return (long) (((unsigned long) x & ~(0xFFUL << shift)) | ((unsigned long) c << shift));
+}
+
+int test_isLess64(long x, long y) {
+    return x < y;
+}
+
+long test_rotateLeft64(long x, int n) {
+    unsigned long u = (unsigned long) x;
+    return (long) ((u << n) | (u >> ((64 - n) & 63)));
+}
+
+long test_bitMask64(int highbit, int lowbit) {
+    return (long) ((~0UL >> (63 - highbit)) & (~0UL << lowbit));
+}
+
+unsigned long test_doubleScale2(unsigned long uf) {
+    union unsigned_double {
+        unsigned long u;
+        double d;
+    };
+
+    union unsigned_double x;
+    x.u = uf;
+    // Multiplying would quiet a signaling NaN, but NaNs are returned as is
+    if (isnan(x.d)) {
+        return uf;
+    }
+    x.d *= 2;
+    return x.u;
+}
+
+int test_isPower2_64(long x) {
+    return x > 0 && (x & (x - 1)) == 0;
+}
+
+/*
+ * Reference oracles: straightforward bit-at-a-time versions of the
+ * oracles above, kept so that btest --reference-oracle can check the
+ * fast oracles against them
+ */
+
+int ref_allOddBits(int x) {
+    for (int i = 1; i < 32; i += 2) {
+        if ((x & (1 << i)) == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int ref_anyEvenBit(int x) {
+    for (int i = 0; i < 32; i += 2) {
+        if (x & (1 << i)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int ref_rotateLeft(int x, int n) {
+    unsigned u = (unsigned) x;
+    for (int i = 0; i < n; i++) {
+        unsigned msb = u >> 31;
+        unsigned rest = u << 1;
+        u = rest | msb;
+    }
+    return (int) u;
+}
+
+int ref_bitMask(int highbit, int lowbit) {
+    int result = 0;
+    for (int i = lowbit; i <= highbit; i++) {
+        result |= 1 << i;
+    }
+    return result;
+}
+
+int ref_isPower2(int x) {
     for (int i = 0; i < 31; i++) {
         if (x == 1 << i)
             return 1;
     }
     return 0;
 }
-
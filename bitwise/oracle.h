@@ -16,4 +16,25 @@ int test_isPower2(int);
 int test_replaceByte(int, int, int);
 int test_rotateLeft(int, int);
 
+// 64-bit versions of the puzzles. Double arguments are passed as their bit pattern
+int test_allOddBits64(long);
+int test_anyEvenBit64(long);
+long test_bitAnd64(long, long);
+long test_bitMask64(int, int);
+long test_bitXor64(long, long);
+int test_doubleIsEqual(unsigned long, unsigned long);
+unsigned long test_doubleScale2(unsigned long);
+int test_isLess64(long, long);
+int test_isPositive64(long);
+int test_isPower2_64(long);
+long test_replaceByte64(long, int, int);
+long test_rotateLeft64(long, int);
+
+// Slower reference versions of some oracles, see btest --reference-oracle
+int ref_allOddBits(int);
+int ref_anyEvenBit(int);
+int ref_bitMask(int, int);
+int ref_isPower2(int);
+int ref_rotateLeft(int, int);
+
 #endif    // ORACLE_H
@@ -17,6 +17,7 @@ puzzle_spec_t puzzle_specs[] = {
         .arg_max = {INT_MAX, INT_MAX, 0},
         .test_func = (int (*)(void)) test_bitXor,
         .impl_func = (int (*)(void)) bitXor,
+        .batch_func = (int (*)(void)) bitXor_n,
     },
     {
         .name = "bitAnd",
@@ -27,6 +28,7 @@ puzzle_spec_t puzzle_specs[] = {
         .arg_max = {INT_MAX, INT_MAX, 0},
         .test_func = (int (*)(void)) test_bitAnd,
         .impl_func = (int (*)(void)) bitAnd,
+        .batch_func = (int (*)(void)) bitAnd_n,
     },
     {
         .name = "allOddBits",
@@ -37,6 +39,8 @@ puzzle_spec_t puzzle_specs[] = {
         .arg_max = {INT_MAX, 0, 0},
         .test_func = (int (*)(void)) test_allOddBits,
         .impl_func = (int (*)(void)) allOddBits,
+        .batch_func = (int (*)(void)) allOddBits_n,
+        .ref_func = (int (*)(void)) ref_allOddBits,
     },
     {
         .name = "floatIsEqual",
@@ -47,6 +51,7 @@ puzzle_spec_t puzzle_specs[] = {
         .arg_max = {UINT_MAX, UINT_MAX, 0},
         .test_func = (int (*)(void)) test_floatIsEqual,
         .impl_func = (int (*)(void)) floatIsEqual,
+        .batch_func = (int (*)(void)) floatIsEqual_n,
     },
     {
         .name = "anyEvenBit",
@@ -57,6 +62,8 @@ puzzle_spec_t puzzle_specs[] = {
         .arg_max = {INT_MAX, 0, 0},
         .test_func = (int (*)(void)) test_anyEvenBit,
         .impl_func = (int (*)(void)) anyEvenBit,
+        .batch_func = (int (*)(void)) anyEvenBit_n,
+        .ref_func = (int (*)(void)) ref_anyEvenBit,
     },
     {
         .name = "isPositive",
@@ -67,6 +74,7 @@ puzzle_spec_t puzzle_specs[] = {
         .arg_max = {INT_MAX, 0, 0},
         .test_func = (int (*)(void)) test_isPositive,
         .impl_func = (int (*)(void)) isPositive,
+        .batch_func = (int (*)(void)) isPositive_n,
     },
     {
         .name = "replaceByte",
@@ -77,6 +85,7 @@ puzzle_spec_t puzzle_specs[] = {
         .arg_max = {INT_MAX, 3, 255},
         .test_func = (int (*)(void)) test_replaceByte,
         .impl_func = (int (*)(void)) replaceByte,
+        .batch_func = (int (*)(void)) replaceByte_n,
     },
     {
         .name = "isLess",
@@ -87,6 +96,7 @@ puzzle_spec_t puzzle_specs[] = {
         .arg_max = {INT_MAX, INT_MAX, 0},
         .test_func = (int (*)(void)) test_isLess,
         .impl_func = (int (*)(void)) isLess,
+        .batch_func = (int (*)(void)) isLess_n,
     },
     {
         .name = "rotateLeft",
@@ -97,6 +107,8 @@ puzzle_spec_t puzzle_specs[] = {
         .arg_max = {INT_MAX, 31, 0},
         .test_func = (int (*)(void)) test_rotateLeft,
         .impl_func = (int (*)(void)) rotateLeft,
+        .batch_func = (int (*)(void)) rotateLeft_n,
+        .ref_func = (int (*)(void)) ref_rotateLeft,
     },
     {
         .name = "bitMask",
@@ -107,6 +119,8 @@ puzzle_spec_t puzzle_specs[] = {
         .arg_max = {31, 31, 0},
         .test_func = (int (*)(void)) test_bitMask,
         .impl_func = (int (*)(void)) bitMask,
+        .batch_func = (int (*)(void)) bitMask_n,
+        .ref_func = (int (*)(void)) ref_bitMask,
     },
     {
         .name = "floatScale2",
@@ -117,6 +131,7 @@ puzzle_spec_t puzzle_specs[] = {
         .arg_max = {UINT_MAX, 0, 0},
         .test_func = (int (*)(void)) test_floatScale2,
         .impl_func = (int (*)(void)) floatScale2,
+        .batch_func = (int (*)(void)) floatScale2_n,
     },
     {
         .name = "isPower2",
@@ -127,6 +142,130 @@ puzzle_spec_t puzzle_specs[] = {
         .arg_max = {INT_MAX, 0, 0},
         .test_func = (int (*)(void)) test_isPower2,
         .impl_func = (int (*)(void)) isPower2,
+        .batch_func = (int (*)(void)) isPower2_n,
+        .ref_func = (int (*)(void)) ref_isPower2,
+    },
+    // 64-bit versions, which have no batched or reference versions. Double
+    // arguments take any bit pattern, so their bounds are unused
+    {
+        .name = "bitXor64",
+        .return_type = LONG_RET,
+        .num_args = 2,
+        .arg_types = {LONG_ARG, LONG_ARG, UNUSED_ARG},
+        .arg_min = {LONG_MIN, LONG_MIN, 0},
+        .arg_max = {LONG_MAX, LONG_MAX, 0},
+        .test_func = (int (*)(void)) test_bitXor64,
+        .impl_func = (int (*)(void)) bitXor64,
+    },
+    {
+        .name = "bitAnd64",
+        .return_type = LONG_RET,
+        .num_args = 2,
+        .arg_types = {LONG_ARG, LONG_ARG, UNUSED_ARG},
+        .arg_min = {LONG_MIN, LONG_MIN, 0},
+        .arg_max = {LONG_MAX, LONG_MAX, 0},
+        .test_func = (int (*)(void)) test_bitAnd64,
+        .impl_func = (int (*)(void)) bitAnd64,
+    },
+    {
+        .name = "allOddBits64",
+        .return_type = INT_RET,
+        .num_args = 1,
+        .arg_types = {LONG_ARG, UNUSED_ARG, UNUSED_ARG},
+        .arg_min = {LONG_MIN, 0, 0},
+        .arg_max = {LONG_MAX, 0, 0},
+        .test_func = (int (*)(void)) test_allOddBits64,
+        .impl_func = (int (*)(void)) allOddBits64,
+    },
+    {
+        .name = "doubleIsEqual",
+        .return_type = INT_RET,
+        .num_args = 2,
+        .arg_types = {DOUBLE_AS_ULONG_ARG, DOUBLE_AS_ULONG_ARG, UNUSED_ARG},
+        .arg_min = {LONG_MIN, LONG_MIN, 0},
+        .arg_max = {LONG_MAX, LONG_MAX, 0},
+        .test_func = (int (*)(void)) test_doubleIsEqual,
+        .impl_func = (int (*)(void)) doubleIsEqual,
+    },
+    {
+        .name = "anyEvenBit64",
+        .return_type = INT_RET,
+        .num_args = 1,
+        .arg_types = {LONG_ARG, UNUSED_ARG, UNUSED_ARG},
+        .arg_min = {LONG_MIN, 0, 0},
+        .arg_max = {LONG_MAX, 0, 0},
+        .test_func = (int (*)(void)) test_anyEvenBit64,
+        .impl_func = (int (*)(void)) anyEvenBit64,
+    },
+    {
+        .name = "isPositive64",
+        .return_type = INT_RET,
+        .num_args = 1,
+        .arg_types = {LONG_ARG, UNUSED_ARG, UNUSED_ARG},
+        .arg_min = {LONG_MIN, 0, 0},
+        .arg_max = {LONG_MAX, 0, 0},
+        .test_func = (int (*)(void)) test_isPositive64,
+        .impl_func = (int (*)(void)) isPositive64,
+    },
+    {
+        .name = "replaceByte64",
+        .return_type = LONG_RET,
+        .num_args = 3,
+        .arg_types = {LONG_ARG, INT_ARG, INT_ARG},
+        .arg_min = {LONG_MIN, 0, 0},
+        .arg_max = {LONG_MAX, 7, 255},
+        .test_func = (int (*)(void)) test_replaceByte64,
+        .impl_func = (int (*)(void)) replaceByte64,
+    },
+    {
+        .name = "isLess64",
+        .return_type = INT_RET,
+        .num_args = 2,
+        .arg_types = {LONG_ARG, LONG_ARG, UNUSED_ARG},
+        .arg_min = {LONG_MIN, LONG_MIN, 0},
+        .arg_max = {LONG_MAX, LONG_MAX, 0},
+        .test_func = (int (*)(void)) test_isLess64,
+        .impl_func = (int (*)(void)) isLess64,
+    },
+    {
+        .name = "rotateLeft64",
+        .return_type = LONG_RET,
+        .num_args = 2,
+        .arg_types = {LONG_ARG, INT_ARG, UNUSED_ARG},
+        .arg_min = {LONG_MIN, 0, 0},
+        .arg_max = {LONG_MAX, 63, 0},
+        .test_func = (int (*)(void)) test_rotateLeft64,
+        .impl_func = (int (*)(void)) rotateLeft64,
+    },
+    {
+        .name = "bitMask64",
+        .return_type = LONG_RET,
+        .num_args = 2,
+        .arg_types = {INT_ARG, INT_ARG, UNUSED_ARG},
+        .arg_min = {0, 0, 0},
+        .arg_max = {63, 63, 0},
+        .test_func = (int (*)(void)) test_bitMask64,
+        .impl_func = (int (*)(void)) bitMask64,
+    },
+    {
+        .name = "doubleScale2",
+        .return_type = UNSIGNED_LONG_RET,
+        .num_args = 1,
+        .arg_types = {DOUBLE_AS_ULONG_ARG, UNUSED_ARG, UNUSED_ARG},
+        .arg_min = {LONG_MIN, 0, 0},
+        .arg_max = {LONG_MAX, 0, 0},
+        .test_func = (int (*)(void)) test_doubleScale2,
+        .impl_func = (int (*)(void)) doubleScale2,
+    },
+    {
+        .name = "isPower2_64",
+        .return_type = INT_RET,
+        .num_args = 1,
+        .arg_types = {LONG_ARG, UNUSED_ARG, UNUSED_ARG},
+        .arg_min = {LONG_MIN, 0, 0},
+        .arg_max = {LONG_MAX, 0, 0},
+        .test_func = (int (*)(void)) test_isPower2_64,
+        .impl_func = (int (*)(void)) isPower2_64,
     },
     // Sentinel value at end
     {
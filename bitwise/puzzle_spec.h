@@ -6,12 +6,16 @@
 enum returnType {
     INT_RET,
     UNSIGNED_RET,
+    LONG_RET,
+    UNSIGNED_LONG_RET,
 };
 
 enum argType {
     INT_ARG,
     UNSIGNED_ARG,
     FLOAT_AS_UNSIGNED_ARG,
+    LONG_ARG,
+    DOUBLE_AS_ULONG_ARG,
     UNUSED_ARG,
 };
 
@@ -20,10 +24,12 @@ typedef struct {
     enum returnType return_type;
     unsigned num_args;
     enum argType arg_types[3];
-    int arg_min[3];            // Bounds are inclusive
-    int arg_max[3];            // Bounds are inclusive
+    long arg_min[3];           // Bounds are inclusive
+    long arg_max[3];           // Bounds are inclusive
     int (*test_func)(void);    // Function pointer that will be cast as needed
     int (*impl_func)(void);    // Function pointer that will be cast as needed
+    int (*batch_func)(void);   // Batched impl_func, also cast as needed
+    int (*ref_func)(void);     // Reference version of test_func, or NULL if there is none
 } puzzle_spec_t;
 
 extern puzzle_spec_t puzzle_specs[];
@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+#ifndef PUZZLE_TABLE_H
+#define PUZZLE_TABLE_H
+
+/*
+ * The C signature of every puzzle, for code that is generated once per
+ * puzzle rather than dispatched on the types in its puzzle_spec_t.
+ * FOR_EACH_PUZZLE expands one of its three macro arguments per puzzle,
+ * depending on how many arguments the puzzle takes:
+ *   UNARY(name, return type, arg1 type)
+ *   BINARY(name, return type, arg1 type, arg2 type)
+ *   TERNARY(name, return type, arg1 type, arg2 type, arg3 type)
+ * Each entry must match the prototypes of name and test_name in bits.h
+ * and oracle.h. Float and double arguments are passed as their unsigned
+ * bit pattern
+ */
+#define FOR_EACH_PUZZLE(UNARY, BINARY, TERNARY)              \
+    BINARY(bitXor, int, int, int)                            \
+    BINARY(bitAnd, int, int, int)                            \
+    UNARY(allOddBits, int, int)                              \
+    BINARY(floatIsEqual, int, unsigned, unsigned)            \
+    UNARY(anyEvenBit, int, int)                              \
+    UNARY(isPositive, int, int)                              \
+    TERNARY(replaceByte, int, int, int, int)                 \
+    BINARY(isLess, int, int, int)                            \
+    BINARY(rotateLeft, int, int, int)                        \
+    BINARY(bitMask, int, int, int)                           \
+    UNARY(floatScale2, unsigned, unsigned)                   \
+    UNARY(isPower2, int, int)                                \
+    BINARY(bitXor64, long, long, long)                       \
+    BINARY(bitAnd64, long, long, long)                       \
+    UNARY(allOddBits64, int, long)                           \
+    BINARY(doubleIsEqual, int, unsigned long, unsigned long) \
+    UNARY(anyEvenBit64, int, long)                           \
+    UNARY(isPositive64, int, long)                           \
+    TERNARY(replaceByte64, long, long, int, int)             \
+    BINARY(isLess64, int, long, long)                        \
+    BINARY(rotateLeft64, long, long, int)                    \
+    BINARY(bitMask64, long, int, int)                        \
+    UNARY(doubleScale2, unsigned long, unsigned long)        \
+    UNARY(isPower2_64, int, long)
+
+#endif    // PUZZLE_TABLE_H
@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bits.h"
+#include "oracle.h"
+#include "reduce.h"
+
+#define REDUCTION(name) {#name, count_##name, any_##name, all_##name, test_##name}
+
+const reduction_t reductions[] = {
+    REDUCTION(allOddBits),
+    REDUCTION(anyEvenBit),
+    REDUCTION(isPositive),
+    REDUCTION(isPower2),
+    {NULL},
+};
+
+const char *reduce_op_names[NUM_REDUCE_OPS] = {"count", "any", "all"};
+
+const reduction_t *find_reduction(const char *puzzle) {
+    for (const reduction_t *r = reductions; r->puzzle != NULL; r++) {
+        if (strcmp(r->puzzle, puzzle) == 0) {
+            return r;
+        }
+    }
+    return NULL;
+}
+
+/* The part of a reduction one thread computes */
+typedef struct {
+    const reduction_t *reduction;
+    reduce_op_t op;
+    const int *x;
+    size_t n;
+    atomic_bool *decided;    // Set by the thread that finds the answer to any or all
+    size_t result;
+} reduce_part_t;
+
+/*
+ * reduce_worker - Reduce one thread's part a chunk at a time. An any or
+ * all reduction gives up once another thread has decided the answer,
+ * and its own result no longer matters
+ */
+static void *reduce_worker(void *arg) {
+    reduce_part_t *part = arg;
+    const reduction_t *r = part->reduction;
+    part->result = part->op == REDUCE_ALL;
+    for (size_t begin = 0; begin < part->n; begin += REDUCE_CHUNK) {
+        size_t len = part->n - begin < REDUCE_CHUNK ? part->n - begin : REDUCE_CHUNK;
+        const int *chunk = part->x + begin;
+        switch (part->op) {
+            case REDUCE_COUNT:
+                part->result += r->count(chunk, len);
+                break;
+
+            case REDUCE_ANY:
+            case REDUCE_ALL:
+                if (atomic_load_explicit(part->decided, memory_order_relaxed)) {
+                    return NULL;
+                }
+                if (part->op == REDUCE_ANY ? r->any(chunk, len) : !r->all(chunk, len)) {
+                    part->result = part->op == REDUCE_ANY;
+                    atomic_store_explicit(part->decided, true, memory_order_relaxed);
+                    return NULL;
+                }
+                break;
+
+            case NUM_REDUCE_OPS:
+                printf("Error: Invalid reduction\n");
+                exit(1);
+        }
+    }
+    return NULL;
+}
+
+size_t reduce_words(const reduction_t *r, reduce_op_t op, const int *x, size_t n,
+                    unsigned num_threads) {
+    size_t num_chunks = (n + REDUCE_CHUNK - 1) / REDUCE_CHUNK;
+    if (num_threads > num_chunks) {
+        num_threads = num_chunks;
+    }
+    if (num_threads > MAX_REDUCE_THREADS) {
+        num_threads = MAX_REDUCE_THREADS;
+    }
+    if (num_threads == 0) {
+        num_threads = 1;
+    }
+
+    reduce_part_t *parts = malloc(num_threads * sizeof(parts[0]));
+    pthread_t *threads = malloc(num_threads * sizeof(threads[0]));
+    if (parts == NULL || threads == NULL) {
+        printf("Error: Out of memory\n");
+        exit(1);
+    }
+    atomic_bool decided = false;
+    size_t begin = 0;
+    for (unsigned t = 0; t < num_threads; t++) {
+        size_t len = n / num_threads + (t < n % num_threads);
+        parts[t] = (reduce_part_t) {r, op, x + begin, len, &decided, 0};
+        begin += len;
+    }
+    // The calling thread reduces the first part itself
+    for (unsigned t = 1; t < num_threads; t++) {
+        if (pthread_create(&threads[t], NULL, reduce_worker, &parts[t]) != 0) {
+            printf("Error: Failed to start reduction thread\n");
+            exit(1);
+        }
+    }
+    reduce_worker(&parts[0]);
+    for (unsigned t = 1; t < num_threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    size_t result = op == REDUCE_ALL;
+    for (unsigned t = 0; t < num_threads; t++) {
+        switch (op) {
+            case REDUCE_COUNT:
+                result += parts[t].result;
+                break;
+
+            case REDUCE_ANY:
+                result |= parts[t].result;
+                break;
+
+            case REDUCE_ALL:
+                result &= parts[t].result;
+                break;
+
+            case NUM_REDUCE_OPS:
+                break;
+        }
+    }
+    free(parts);
+    free(threads);
+    return result;
+}
+
+size_t reduce_oracle(const reduction_t *r, reduce_op_t op, const int *x, size_t n) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        count += r->oracle(x[i]) != 0;
+    }
+    switch (op) {
+        case REDUCE_ANY:
+            return count > 0;
+
+        case REDUCE_ALL:
+            return count == n;
+
+        default:
+            return count;
+    }
+}
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+#ifndef REDUCE_H
+#define REDUCE_H
+
+#include <stddef.h>
+
+/* Most threads reduce_words() splits a reduction across */
+#define MAX_REDUCE_THREADS 1024
+
+/* Words each thread reduces at a time, 1 MiB. Between chunks it checks
+   whether another thread has already decided an any or all reduction,
+   and smaller parts aren't worth a thread of their own */
+#define REDUCE_CHUNK (1ul << 18)
+
+/* The reductions bits_reduce.s provides for each predicate puzzle */
+typedef enum {
+    REDUCE_COUNT,    // Number of words the puzzle is true for
+    REDUCE_ANY,      // 1 if it is true for any word
+    REDUCE_ALL,      // 1 if it is true for every word
+    NUM_REDUCE_OPS,
+} reduce_op_t;
+
+/* Names of the reductions, the prefixes of their kernels, e.g. "count" */
+extern const char *reduce_op_names[NUM_REDUCE_OPS];
+
+/* The reduction kernels of one predicate puzzle, and its oracle */
+typedef struct {
+    const char *puzzle;                      // Name of the puzzle in puzzle_specs
+    size_t (*count)(const int *, size_t);    // count_NAME
+    int (*any)(const int *, size_t);         // any_NAME
+    int (*all)(const int *, size_t);         // all_NAME
+    int (*oracle)(int);                      // test_NAME
+} reduction_t;
+
+/* Every predicate with reductions. Ends with a NULL puzzle */
+extern const reduction_t reductions[];
+
+/*
+ * find_reduction - Return the reductions of puzzle, or NULL if it has none
+ */
+const reduction_t *find_reduction(const char *puzzle);
+
+/*
+ * reduce_words - Compute op over the n words at x with the kernels of r,
+ * split across up to num_threads threads that each take a contiguous
+ * part of x. For any and all, every thread stops soon after one of them
+ * finds a word that decides the answer. The CPU must support AVX2
+ */
+size_t reduce_words(const reduction_t *r, reduce_op_t op, const int *x, size_t n,
+                    unsigned num_threads);
+
+/*
+ * reduce_oracle - Compute op over the n words at x one word at a time
+ * with r's oracle
+ */
+size_t reduce_oracle(const reduction_t *r, reduce_op_t op, const int *x, size_t n);
+
+#endif    // REDUCE_H
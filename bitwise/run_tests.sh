@@ -14,9 +14,9 @@ cc_check_result=$?
 
 if [ "$cc_check_result" -eq 0 ]; then
     if [ $# -gt 0 ]; then
-        ./testius $test_cases_file -v -n "$1";
+        ./testius $test_cases_file -v -n "$1" --jobs "$(nproc)";
     else
-        ./testius $test_cases_file;
+        ./testius $test_cases_file --jobs "$(nproc)";
     fi
 else
     echo
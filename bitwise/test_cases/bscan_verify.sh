@@ -0,0 +1,42 @@
+#! /bin/bash
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Runs every reduction bscan has over the same file of words, checking each
+# result against the puzzle's oracle, and prints the ones that fail, so a
+# passing run prints nothing. bscan skips the scan without failing on a
+# CPU that lacks AVX2, so that is silent too. The file is
+# generated from a fixed seed, with a mix of words each predicate is true
+# and false for, and a length that is not a multiple of any vector width
+# so the tails are covered too. Any arguments are a command to run bscan
+# under, such as an emulator
+# Usage: bash test_cases/bscan_verify.sh [runner...]
+words=$(mktemp) || exit 1
+trap 'rm -f "$words"' EXIT
+
+python3 - "$words" <<'EOF'
+import random
+import struct
+import sys
+
+rng = random.Random(1)
+values = []
+for i in range(100003):
+    x = rng.getrandbits(32)
+    kind = i % 4
+    if kind == 1:
+        x = 1 << (x % 32)
+    elif kind == 2:
+        x |= 0xAAAAAAAA
+    elif kind == 3:
+        x &= 0xAAAAAAAA
+    values.append(x)
+with open(sys.argv[1], "wb") as f:
+    f.write(struct.pack(f"<{len(values)}I", *values))
+EOF
+
+for puzzle in allOddBits anyEvenBit isPositive isPower2; do
+    for op in count any all; do
+        if ! result=$("$@" ./bscan -j 4 --verify "$op" "$puzzle" "$words"); then
+            echo "$op $puzzle: $result"
+        fi
+    done
+done